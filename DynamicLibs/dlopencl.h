@@ -71,6 +71,13 @@ public:
   decltype(clEnqueueReadBuffer)* EnqueueReadBuffer = dll_["clEnqueueReadBuffer"];
   decltype(clEnqueueNDRangeKernel)* EnqueueNDRangeKernel = dll_["clEnqueueNDRangeKernel"];
   decltype(clFlush)* Flush = dll_["clFlush"];
+  decltype(clReleaseKernel)* ReleaseKernel = dll_["clReleaseKernel"];
+  decltype(clReleaseProgram)* ReleaseProgram = dll_["clReleaseProgram"];
+  decltype(clReleaseMemObject)* ReleaseMemObject = dll_["clReleaseMemObject"];
+  decltype(clReleaseCommandQueue)* ReleaseCommandQueue = dll_["clReleaseCommandQueue"];
+  decltype(clReleaseContext)* ReleaseContext = dll_["clReleaseContext"];
+  decltype(clWaitForEvents)* WaitForEvents = dll_["clWaitForEvents"];
+  decltype(clReleaseEvent)* ReleaseEvent = dll_["clReleaseEvent"];
 };
 
 #endif // !defined(_DLOPENCL_H_)
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "autotune.h"
+#include "miner_state.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+using namespace std::chrono;
+
+namespace
+{
+  // GPU intensities are tried from here up, a whole step at a time
+  static double constexpr MIN_INTENSITY{ 16.0 };
+  static double constexpr MAX_INTENSITY{ 34.0 };
+  // the smallest OpenCL local work size tried; each after that doubles
+  static uint32_t constexpr MIN_WORK_SIZE{ 32u };
+
+  // a hashrate counts once it moves less than SETTLED between polls, at
+  // least MIN_SETTLE in, or after MAX_SETTLE regardless
+  static double constexpr SETTLED{ 0.02 };
+  static auto constexpr POLL{ 500ms };
+  static auto constexpr MIN_SETTLE{ 3s };
+  static auto constexpr MAX_SETTLE{ 20s };
+
+  // this close to the best hashrate, a shorter launch (or fewer CPU
+  // threads) is worth more than the difference
+  static double constexpr NEAR_BEST{ 0.01 };
+
+  // the CPU solver's own hashrate window, short enough to follow each
+  // change of thread count
+  static auto constexpr CPU_WINDOW{ 2s };
+
+  static std::mutex m_stop_mutex;
+  static std::condition_variable m_stop_cv;
+  static bool m_stop{ false };
+
+  struct point_t
+  {
+    double intensity;
+    uint32_t work_size;
+    double hashrate;
+    double launch;
+  };
+
+  // waits for `hashrate` to settle and returns it, or -1 if stopped first
+  static auto measure( std::function<double()> const& hashrate ) -> double
+  {
+    auto const start{ steady_clock::now() };
+    double last{ -1. };
+
+    cond_lock lock{ m_stop_mutex };
+    while( !m_stop_cv.wait_for( lock, POLL, []{ return m_stop; } ) )
+    {
+      double const now{ hashrate() };
+      auto const elapsed{ steady_clock::now() - start };
+      if( elapsed >= MAX_SETTLE ||
+          ( elapsed >= MIN_SETTLE && last > 0. && std::abs( now - last ) <= last * SETTLED ) )
+      {
+        return now;
+      }
+      last = now;
+    }
+    return -1.;
+  }
+
+  // runs one GPU, alone, at one setting
+  static auto tryPoint( Nabiki::Autotune::device_t const& gpu, double const& intensity,
+                        uint32_t const& work_size ) -> point_t
+  {
+    auto solver{ gpu.make( intensity, work_size ) };
+    solver->startFinding();
+    double const hashrate{ measure( [&solver]{ return solver->getHashrate(); } ) };
+    point_t const point{ intensity, work_size, hashrate, solver->getLaunchTime() };
+    solver->stopFinding();
+
+    if( hashrate >= 0. )
+    {
+      std::stringstream ss_out;
+      ss_out << std::fixed << std::setprecision( 2 ) << gpu.name << ": intensity "sv << intensity;
+      if( work_size > 0u )
+      {
+        ss_out << ", work size "sv << work_size;
+      }
+      ss_out << " - "sv << hashrate << " MH/s, "sv << point.launch << " ms per launch"sv;
+      Log::pushLog( ss_out.str() );
+    }
+
+    return point;
+  }
+
+  // the fastest point, unless a shorter launch comes at next to no cost
+  static auto pickBest( std::vector<point_t> const& points ) -> point_t
+  {
+    auto const fastest{ std::max_element( points.begin(), points.end(),
+                                          []( point_t const& a, point_t const& b )
+                                          { return a.hashrate < b.hashrate; } ) };
+    point_t best{ *fastest };
+    for( auto const& point : points )
+    {
+      if( point.hashrate >= fastest->hashrate * (1. - NEAR_BEST) && point.launch < best.launch )
+      {
+        best = point;
+      }
+    }
+    return best;
+  }
+
+  static auto tuneGpu( Nabiki::Autotune::device_t const& gpu, double const& max_launch_ms, point_t& best ) -> bool
+  {
+    // every intensity past the first one over the limit only launches
+    // for longer still; if even the lowest is over, it's that or nothing
+    std::vector<point_t> points;
+    for( double intensity{ MIN_INTENSITY }; intensity <= MAX_INTENSITY; intensity += 1.0 )
+    {
+      auto const point{ tryPoint( gpu, intensity, 0u ) };
+      if( point.hashrate < 0. ) { return false; }
+      if( point.launch > max_launch_ms && !points.empty() ) { break; }
+      points.emplace_back( point );
+      if( point.launch > max_launch_ms ) { break; }
+    }
+    best = pickBest( points );
+
+    // 0 already stands for the largest size the kernel allows
+    if( gpu.max_work_size > 0u )
+    {
+      std::vector<point_t> sizes{ best };
+      for( uint32_t work_size{ MIN_WORK_SIZE }; work_size < gpu.max_work_size; work_size *= 2u )
+      {
+        auto const point{ tryPoint( gpu, best.intensity, work_size ) };
+        if( point.hashrate < 0. ) { return false; }
+        if( point.launch <= max_launch_ms )
+        {
+          sizes.emplace_back( point );
+        }
+      }
+      best = pickBest( sizes );
+    }
+
+    return true;
+  }
+
+  // with `running` going flat out, finds the CPU thread count giving the
+  // best total; 0 if stopped
+  static auto tuneCpu( std::vector<std::shared_ptr<ISolver>> const& running, CPUSolver& cpu,
+                       std::string const& cpu_name ) -> uint32_t
+  {
+    cpu.startFinding();
+    uint32_t const most{ cpu.getThreadCount() };
+    uint32_t const step{ std::max( most / 8u, 1u ) };
+
+    std::vector<std::pair<uint32_t, double>> totals;
+    for( uint32_t count{ step }; ; count = std::min( count + step, most ) )
+    {
+      cpu.setThreadCount( count );
+      double const total{ measure( [&]
+      {
+        double sum{ cpu.getHashrate( CPU_WINDOW ) };
+        for( auto const& solver : running )
+        {
+          sum += solver->getHashrate();
+        }
+        return sum;
+      } ) };
+      if( total < 0. ) { break; }
+
+      std::stringstream ss_out;
+      ss_out << std::fixed << std::setprecision( 2 ) << cpu_name << ": "sv << count
+             << " thread"sv << (count > 1u ? "s"sv : ""sv) << " - "sv << total << " MH/s in total"sv;
+      Log::pushLog( ss_out.str() );
+
+      totals.emplace_back( count, total );
+      if( count == most ) { break; }
+    }
+    cpu.stopFinding();
+
+    if( totals.empty() || totals.back().first != most ) { return 0u; }
+
+    // fewer threads leave more of the machine alone, for next to no cost
+    double best{ 0. };
+    for( auto const& [ count, total ] : totals )
+    {
+      best = std::max( best, total );
+    }
+    for( auto const& [ count, total ] : totals )
+    {
+      if( total >= best * (1. - NEAR_BEST) ) { return count; }
+    }
+    return most;
+  }
+}
+
+namespace Nabiki::Autotune
+{
+  auto Run( std::vector<device_t> const& gpus, std::shared_ptr<CPUSolver> const& cpu,
+            std::string const& cpu_name, double const& max_launch_ms ) -> std::string
+  {
+    // devices are keyed by name, so identical ones are only tuned once
+    std::vector<point_t> picks;
+    for( size_t i{ 0u }; i < gpus.size(); ++i )
+    {
+      auto const twin{ std::find_if( gpus.begin(), gpus.begin() + i,
+                                     [&]( device_t const& gpu ){ return gpu.name == gpus[i].name; } ) };
+      if( twin != gpus.begin() + i )
+      {
+        picks.emplace_back( picks[size_t( twin - gpus.begin() )] );
+        continue;
+      }
+
+      point_t best{};
+      if( !tuneGpu( gpus[i], max_launch_ms, best ) ) { return {}; }
+      picks.emplace_back( best );
+    }
+
+    uint32_t threads{ 0u };
+    if( cpu )
+    {
+      std::vector<std::shared_ptr<ISolver>> running;
+      for( size_t i{ 0u }; i < gpus.size(); ++i )
+      {
+        running.emplace_back( gpus[i].make( picks[i].intensity, picks[i].work_size ) );
+        running.back()->startFinding();
+      }
+
+      threads = tuneCpu( running, *cpu, cpu_name );
+
+      for( auto const& solver : running )
+      {
+        solver->stopFinding();
+      }
+      if( threads == 0u ) { return {}; }
+    }
+
+    std::stringstream ss_out;
+    ss_out << std::fixed << std::setprecision( 2 ) << "\nAutotune results ("sv
+           << max_launch_ms << " ms per launch at most)\n"sv;
+    for( size_t i{ 0u }; i < gpus.size(); ++i )
+    {
+      MinerState::setTuning( gpus[i].name, tuning_t{ picks[i].intensity, picks[i].work_size, 0u } );
+
+      ss_out << "  "sv << gpus[i].name << ": intensity "sv << picks[i].intensity;
+      if( picks[i].work_size > 0u )
+      {
+        ss_out << ", work size "sv << picks[i].work_size;
+      }
+      ss_out << " - "sv << picks[i].hashrate << " MH/s, "sv << picks[i].launch << " ms per launch\n"sv;
+    }
+    if( cpu )
+    {
+      MinerState::setTuning( cpu_name, tuning_t{ 0., 0u, threads } );
+
+      ss_out << "  "sv << cpu_name << ": "sv << threads << " thread"sv << (threads > 1u ? "s\n"sv : "\n"sv);
+    }
+
+    ss_out << (MinerState::saveTuning()
+               ? "Saved to nabiki.json.\n"sv
+               : "Unable to update nabiki.json.\n"sv);
+
+    return ss_out.str();
+  }
+
+  auto Stop() -> void
+  {
+    {
+      guard lock{ m_stop_mutex };
+      m_stop = true;
+    }
+    m_stop_cv.notify_all();
+  }
+}
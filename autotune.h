@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _AUTOTUNE_H_
+#define _AUTOTUNE_H_
+
+#include "types.h"
+#include "isolver.h"
+#include "cpusolver.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Nabiki::Autotune
+{
+  // one configured GPU, and how to build a solver for it at a given
+  // intensity and, for OpenCL, local work size (0 for the kernel's own
+  // limit)
+  struct device_t
+  {
+    std::string name;
+    device_type_t type;
+    double intensity;
+    uint32_t max_work_size; // 0 where there's no such setting
+    std::string pci_bus_id; // "dddd:bb:dd.f"; empty if the driver won't say
+    std::function<std::shared_ptr<ISolver>( double const& intensity, uint32_t const& work_size )> make;
+  };
+
+  // Tunes each GPU alone, raising the intensity until a launch takes
+  // longer than `max_launch_ms` and then, for OpenCL, trying each local
+  // work size at the best intensity found. With every GPU running at its
+  // pick, `cpu` is then stepped through its thread counts by total
+  // hashrate, so that GPU host threads get their say. The picks are
+  // saved to nabiki.json; returns a summary, or nothing if stopped.
+  auto Run( std::vector<device_t> const& gpus, std::shared_ptr<CPUSolver> const& cpu,
+            std::string const& cpu_name, double const& max_launch_ms ) -> std::string;
+  // cuts a running Run() short
+  auto Stop() -> void;
+}
+
+#endif // !_AUTOTUNE_H_
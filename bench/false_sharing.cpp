@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Scaling of per-thread counters with and without cache-line padding,
+// against a single shared counter. Build and run from the repo root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. bench/false_sharing.cpp -o false_sharing
+//   ./false_sharing [max threads]
+
+#include "types.h"
+#include "thread_steps.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+using namespace std::literals;
+
+namespace
+{
+  static auto constexpr RUN_TIME{ 250ms };
+
+  struct packed_t
+  {
+    std::atomic<uint64_t> count{ 0u };
+  };
+
+  struct alignas(CACHE_LINE_SIZE) padded_t
+  {
+    std::atomic<uint64_t> count{ 0u };
+  };
+
+  // runs `threads` threads each calling `work( index )` in a loop, and
+  // returns the total calls per second
+  template<typename F>
+  static auto measure( uint32_t const& threads, F&& work ) -> double
+  {
+    std::atomic<bool> go{ false }, stop{ false };
+    std::vector<uint64_t> done( threads );
+    std::vector<std::thread> pool;
+
+    for( uint32_t i{ 0u }; i < threads; ++i )
+    {
+      pool.emplace_back( [&, i]
+      {
+        while( !go.load( std::memory_order_acquire ) ) {}
+        uint64_t n{ 0u };
+        while( !stop.load( std::memory_order_relaxed ) )
+        {
+          for( uint32_t j{ 0u }; j < 1024u; ++j ) { work( i ); }
+          n += 1024u;
+        }
+        done[i] = n;
+      } );
+    }
+
+    auto const start{ steady_clock::now() };
+    go.store( true, std::memory_order_release );
+    std::this_thread::sleep_for( RUN_TIME );
+    stop.store( true, std::memory_order_relaxed );
+    for( auto& thread : pool ) { thread.join(); }
+    double const elapsed{ duration_cast<duration<double>>( steady_clock::now() - start ).count() };
+
+    uint64_t total{ 0u };
+    for( auto const& n : done ) { total += n; }
+    return total / elapsed;
+  }
+}
+
+auto main( int argc, char** argv ) -> int
+{
+  uint32_t const max_threads{ argc > 1
+                              ? static_cast<uint32_t>( std::strtoul( argv[1], nullptr, 10 ) )
+                              : std::max( std::thread::hardware_concurrency(), 1u ) };
+
+  std::cout << "threads      shared Mop/s      packed Mop/s      padded Mop/s\n"sv;
+
+  for( uint32_t threads{ 1u }; threads <= max_threads; threads = nextThreadCount( threads, max_threads ) )
+  {
+    padded_t shared;
+    auto packed{ std::make_unique<packed_t[]>( threads ) };
+    auto padded{ std::make_unique<padded_t[]>( threads ) };
+
+    double const r_shared{ measure( threads, [&]( uint32_t const& )
+    {
+      shared.count.fetch_add( 1u, std::memory_order_acq_rel );
+    } ) };
+    double const r_packed{ measure( threads, [&]( uint32_t const& i )
+    {
+      packed[i].count.fetch_add( 1u, std::memory_order_relaxed );
+    } ) };
+    double const r_padded{ measure( threads, [&]( uint32_t const& i )
+    {
+      padded[i].count.fetch_add( 1u, std::memory_order_relaxed );
+    } ) };
+
+    std::cout << std::setw( 7 ) << threads << std::fixed << std::setprecision( 1 )
+              << std::setw( 18 ) << r_shared / 1e6
+              << std::setw( 18 ) << r_packed / 1e6
+              << std::setw( 18 ) << r_padded / 1e6 << '\n';
+  }
+
+  return 0;
+}
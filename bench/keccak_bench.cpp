@@ -0,0 +1,367 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Hash rates of everything that hashes: sph_keccak256 as used to check
+// solutions, the per-message midstate, every CPU kernel this machine can
+// run (the OpenCL/CUDA kernel source included, as "portable") and the
+// JIT. Each is run at 1, 2, 4 ... N threads. Built and run by
+//
+//   make bench [BENCH_FLAGS="..."]
+//
+// which passes --baseline bench/baseline.json when that file exists.
+// Options:
+//   --threads N      most threads to run (default: every hardware thread)
+//   --time MS        time per measurement (default 1000)
+//   --only NAME      measure only this entry; may be repeated
+//   --json PATH      write the results as JSON
+//   --baseline PATH  compare against JSON written by an earlier run, and
+//                    exit with 1 if anything got slower than --tolerance
+//   --tolerance PCT  allowed slowdown against the baseline (default 5)
+//
+// Cycles are TSC ticks, so they only mean core cycles at the nominal
+// clock, and are left out on anything but x86-64.
+
+#include "cpukernel.h"
+#include "midstate.h"
+#include "platforms.h"
+#include "sph_keccak.h"
+#include "types.h"
+#include "thread_steps.h"
+
+#include <json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined _MSC_VER
+#  include <intrin.h>
+#elif defined __x86_64__
+#  include <x86intrin.h>
+#endif
+
+using namespace std::chrono;
+using namespace std::literals;
+using json = nlohmann::json;
+
+namespace
+{
+  // nonces per kernel call, much as a CPU solver hands out
+  static uint64_t constexpr BATCH{ 1u << 14 };
+
+  struct result_t
+  {
+    std::string name;
+    uint32_t threads;
+    double hashes_per_sec;
+    std::optional<double> cycles_per_hash;
+  };
+
+  // hashes up to `count` nonces from `base`, returning how many it did
+  using work_fn = std::function<uint64_t( uint64_t const& base, uint64_t const& count )>;
+
+  struct entry_t
+  {
+    std::string name;
+    work_fn work;
+  };
+
+  static auto inline ticks() -> uint64_t
+  {
+#if defined __x86_64__ || defined _M_X64
+    return __rdtsc();
+#else
+    return 0u;
+#endif
+  }
+
+  static auto constexpr HAVE_TICKS{
+#if defined __x86_64__ || defined _M_X64
+    true
+#else
+    false
+#endif
+  };
+
+  static auto measure( entry_t const& entry, uint32_t const& threads, milliseconds const& run_time ) -> result_t
+  {
+    std::atomic<bool> go{ false }, stop{ false };
+    std::vector<uint64_t> hashes( threads ), spent( threads );
+    std::vector<std::thread> pool;
+
+    for( uint32_t i{ 0u }; i < threads; ++i )
+    {
+      pool.emplace_back( [&, i]
+      {
+        // far enough apart that no two threads ever hash the same nonce
+        uint64_t nonce{ uint64_t( i ) << 48 };
+        while( !go.load( std::memory_order_acquire ) ) {}
+
+        uint64_t const start{ ticks() };
+        while( !stop.load( std::memory_order_relaxed ) )
+        {
+          nonce += entry.work( nonce, BATCH );
+        }
+        spent[i] = ticks() - start;
+        hashes[i] = nonce - (uint64_t( i ) << 48);
+      } );
+    }
+
+    auto const start{ steady_clock::now() };
+    go.store( true, std::memory_order_release );
+    std::this_thread::sleep_for( run_time );
+    stop.store( true, std::memory_order_relaxed );
+    for( auto& thread : pool ) { thread.join(); }
+    double const elapsed{ duration_cast<duration<double>>( steady_clock::now() - start ).count() };
+
+    uint64_t total{ 0u }, total_ticks{ 0u };
+    for( uint32_t i{ 0u }; i < threads; ++i )
+    {
+      total += hashes[i];
+      total_ticks += spent[i];
+    }
+
+    result_t result{ entry.name, threads, total / elapsed, std::nullopt };
+    if( HAVE_TICKS && total > 0u ) { result.cycles_per_hash = double( total_ticks ) / total; }
+    return result;
+  }
+
+  static auto toJson( std::vector<result_t> const& results ) -> json
+  {
+    json out{ { "cpu", GetRawCpuName() }, { "results", json::array() } };
+    for( auto const& r : results )
+    {
+      out["results"].push_back( { { "name", r.name },
+                                  { "threads", r.threads },
+                                  { "hashes_per_sec", r.hashes_per_sec },
+                                  { "cycles_per_hash", r.cycles_per_hash ? json( *r.cycles_per_hash ) : json() } } );
+    }
+    return out;
+  }
+
+  // prints every result that also appears in the baseline, and returns
+  // whether any of them fell further behind it than `tolerance`
+  static auto compare( std::vector<result_t> const& results, json const& baseline, double const& tolerance ) -> bool
+  {
+    bool regressed{ false };
+
+    std::cout << "\nentry         threads    baseline MH/s     now MH/s    change\n"sv;
+    for( auto const& r : results )
+    {
+      auto const& base_results{ baseline["results"] };
+      auto const found{ std::find_if( base_results.begin(), base_results.end(), [&]( json const& b )
+      {
+        return b.value( "name", ""s ) == r.name && b.value( "threads", 0u ) == r.threads;
+      } ) };
+      if( found == base_results.end() ) { continue; }
+
+      double const before{ found->value( "hashes_per_sec", 0.0 ) };
+      if( before <= 0.0 ) { continue; }
+
+      double const change{ r.hashes_per_sec / before - 1.0 };
+      bool const slower{ change < -tolerance };
+      regressed |= slower;
+
+      std::cout << std::left << std::setw( 14 ) << r.name << std::right
+                << std::setw( 7 ) << r.threads << std::fixed << std::setprecision( 2 )
+                << std::setw( 17 ) << before / 1e6
+                << std::setw( 13 ) << r.hashes_per_sec / 1e6
+                << std::setw( 9 ) << std::showpos << change * 100.0 << std::noshowpos << '%'
+                << ( slower ? "  REGRESSION"sv : ""sv ) << '\n';
+    }
+
+    return regressed;
+  }
+}
+
+auto main( int argc, char** argv ) -> int
+{
+  uint32_t max_threads{ std::max( std::thread::hardware_concurrency(), 1u ) };
+  milliseconds run_time{ 1000ms };
+  double tolerance{ 0.05 };
+  std::vector<std::string> only;
+  std::string json_path, baseline_path;
+
+  for( int i{ 1 }; i < argc; ++i )
+  {
+    std::string_view const arg{ argv[i] };
+    bool const has_value{ i + 1 < argc };
+
+    if( arg == "--threads"sv && has_value )
+    {
+      max_threads = std::max( static_cast<uint32_t>( std::strtoul( argv[++i], nullptr, 10 ) ), 1u );
+    }
+    else if( arg == "--time"sv && has_value )
+    {
+      run_time = milliseconds( std::strtoul( argv[++i], nullptr, 10 ) );
+    }
+    else if( arg == "--only"sv && has_value )
+    {
+      only.emplace_back( argv[++i] );
+    }
+    else if( arg == "--json"sv && has_value )
+    {
+      json_path = argv[++i];
+    }
+    else if( arg == "--baseline"sv && has_value )
+    {
+      baseline_path = argv[++i];
+    }
+    else if( arg == "--tolerance"sv && has_value )
+    {
+      tolerance = std::strtod( argv[++i], nullptr ) / 100.0;
+    }
+    else
+    {
+      std::cerr << "Unknown or incomplete option \""sv << arg << "\"; see the top of bench/keccak_bench.cpp.\n"sv;
+      return 2;
+    }
+  }
+
+  // a random message; the target is zero, so (near enough) nothing is
+  // ever a solution and the kernels never stop early to record one
+  message_t message;
+  {
+    std::mt19937_64 gen{ 0x6e6162696b69ull };
+    for( auto& byte : message ) { byte = static_cast<uint8_t>( gen() ); }
+    std::memset( &message[64], 0, 8 );
+  }
+  midstate_t const mid{ Nabiki::Keccak::precompute( message ) };
+  uint64_t const target{ 0u };
+
+  std::vector<entry_t> entries;
+
+  entries.push_back( { "sph_keccak256"s, [&]( uint64_t const& base, uint64_t const& count ) -> uint64_t
+  {
+    message_t msg{ message };
+    hash_t digest;
+    sph_keccak256_context ctx;
+    for( uint64_t nonce{ base }; nonce < base + count; ++nonce )
+    {
+      std::memcpy( &msg[64], &nonce, sizeof( nonce ) );
+      sph_keccak256_init( &ctx );
+      sph_keccak256( &ctx, msg.data(), msg.size() );
+      sph_keccak256_close( &ctx, digest.data() );
+    }
+    return count;
+  } } );
+
+  // once per challenge rather than per nonce, but still worth watching
+  entries.push_back( { "midstate"s, [&]( uint64_t const& base, uint64_t const& count ) -> uint64_t
+  {
+    message_t msg{ message };
+    for( uint64_t i{ base }; i < base + count; ++i )
+    {
+      std::memcpy( &msg[0], &i, sizeof( i ) );
+      auto volatile const word{ Nabiki::Keccak::precompute( msg )[25] };
+      static_cast<void>( word );
+    }
+    return count;
+  } } );
+
+  for( auto const* kernel : Nabiki::Keccak::usableKernels() )
+  {
+    entries.push_back( { std::string( kernel->name ), [&, kernel]( uint64_t const& base, uint64_t const& count ) -> uint64_t
+    {
+      uint64_t sols[256];
+      uint32_t sol_count{ 0u };
+      kernel->mine( mid, target, base, count, sols, sol_count );
+      return count;
+    } } );
+  }
+
+  if( auto const jit{ Nabiki::Keccak::buildJitKernel( mid, target ) } )
+  {
+    entries.push_back( { "jit"s, [jit]( uint64_t const& base, uint64_t const& count ) -> uint64_t
+    {
+      uint64_t sols[256];
+      uint32_t sol_count{ 0u };
+      jit->mine( base, count, sols, sol_count );
+      return count;
+    } } );
+  }
+
+  if( !only.empty() )
+  {
+    entries.erase( std::remove_if( entries.begin(), entries.end(), [&]( entry_t const& entry )
+    {
+      return std::find( only.begin(), only.end(), entry.name ) == only.end();
+    } ), entries.end() );
+  }
+
+  std::cout << GetRawCpuName() << '\n'
+            << "entry         threads         MH/s   cycles/hash\n"sv;
+
+  std::vector<result_t> results;
+  for( auto const& entry : entries )
+  {
+    for( uint32_t threads{ 1u }; threads <= max_threads; threads = nextThreadCount( threads, max_threads ) )
+    {
+      auto const& r{ results.emplace_back( measure( entry, threads, run_time ) ) };
+
+      std::cout << std::left << std::setw( 14 ) << r.name << std::right
+                << std::setw( 7 ) << r.threads << std::fixed << std::setprecision( 2 )
+                << std::setw( 13 ) << r.hashes_per_sec / 1e6;
+      if( r.cycles_per_hash ) { std::cout << std::setw( 14 ) << *r.cycles_per_hash; }
+      std::cout << '\n';
+    }
+  }
+
+  if( !json_path.empty() )
+  {
+    std::ofstream out{ json_path };
+    out << std::setw( 2 ) << toJson( results ) << '\n';
+    if( !out )
+    {
+      std::cerr << "Could not write "sv << json_path << ".\n"sv;
+      return 2;
+    }
+  }
+
+  if( !baseline_path.empty() )
+  {
+    std::ifstream in{ baseline_path };
+    json const baseline = json::parse( in, nullptr, false );
+    if( baseline.is_discarded() || !baseline.contains( "results" ) )
+    {
+      std::cerr << "Could not read a baseline from "sv << baseline_path << ".\n"sv;
+      return 2;
+    }
+    if( compare( results, baseline, tolerance ) ) { return 1; }
+  }
+
+  return 0;
+}
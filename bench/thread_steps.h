@@ -0,0 +1,39 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _THREAD_STEPS_H_
+#define _THREAD_STEPS_H_
+
+#include <algorithm>
+#include <cstdint>
+
+// Thread counts for the benchmarks to step through: 1, 2, 4 ... and then
+// `max_threads` itself exactly once, whether or not it's a power of two.
+//
+//   for( uint32_t threads{ 1u }; threads <= max_threads; threads = nextThreadCount( threads, max_threads ) )
+static auto inline nextThreadCount( uint32_t const& threads, uint32_t const& max_threads ) -> uint32_t
+{
+  return threads == max_threads ? max_threads + 1u : std::min( threads * 2u, max_threads );
+}
+
+#endif // !_THREAD_STEPS_H_
@@ -27,17 +27,26 @@
 #include "miner_state.h"
 #include "devicetelemetry.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
 using namespace std::literals::string_literals;
 using namespace std::chrono;
 
-CLSolver::CLSolver( cl_device_id const& device, double const& intensity ) noexcept :
+namespace
+{
+  // the longest a new message should wait for work already in the queue
+  static double constexpr CHUNK_MS{ 10.0 };
+}
+
+CLSolver::CLSolver( cl_device_id const& device, double const& intensity, uint32_t const& work_size ) noexcept :
   m_telemetry_handle( Nabiki::MakeDeviceTelemetryObject( device ) ),
   m_stop( false ),
   m_new_target( true ),
   m_new_message( true ),
+  m_switch_start( 0. ),
+  m_switch_time( 0. ),
   m_device_initialized( false ),
   h_solution_count( 0 ),
   h_solutions{},
@@ -46,8 +55,11 @@ CLSolver::CLSolver( cl_device_id const& device, double const& intensity ) noexce
   m_hash_count( 0 ),
   m_first_round_passed( false ),
   m_hash_average( 0 ),
+  m_launch_time( 0 ),
   m_intensity( intensity <= 41.99 ? intensity : 41.99 ),
-  m_threads( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity )) ),
+  m_threads( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity.load() )) ),
+  m_sizer( 0., 1u, 1u ),
+  m_last_launch( 0. ),
   m_round_start( 0ns ),
   m_round_end( 0ns ),
   m_device( device ),
@@ -66,7 +78,7 @@ CLSolver::CLSolver( cl_device_id const& device, double const& intensity ) noexce
 
   d_solution_count = cl.CreateBuffer( m_context, static_cast<cl_mem_flags>(CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR), sizeof( h_solution_count ), nullptr, &error );
   d_solutions = cl.CreateBuffer( m_context, static_cast<cl_mem_flags>(CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR), sizeof( h_solutions ), nullptr, &error );
-  d_mid = cl.CreateBuffer( m_context, static_cast<cl_mem_flags>(CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR), sizeof( state_t ), nullptr, &error );
+  d_mid = cl.CreateBuffer( m_context, static_cast<cl_mem_flags>(CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR), sizeof( midstate_t ), nullptr, &error );
 
   const char* src = clKeccakSource.c_str();
   m_program = cl.CreateProgramWithSource( m_context, 1u, &src, nullptr, &error );
@@ -121,12 +133,18 @@ CLSolver::CLSolver( cl_device_id const& device, double const& intensity ) noexce
   {
     Log::pushLog( "OpenCL error getting work size: "s + std::to_string( error ) );
   }
+  if( work_size > 0u && work_size < m_local_work_size )
+  {
+    m_local_work_size = work_size;
+  }
   if( intensity > 10 )
   {
     m_threads = (m_threads / m_local_work_size) * m_local_work_size;
   }
 
   m_global_work_size = m_threads;
+  m_sizer = LaunchSizer( MinerState::getLaunchTarget(), m_local_work_size,
+                         static_cast<uint64_t>(std::pow( 2, 41.99 )) );
   //Log::pushLog( std::to_string( *m_local_work_size ) + ":"s + std::to_string( m_threads ) );
 
   h_solution_count = 0u;
@@ -139,38 +157,85 @@ CLSolver::~CLSolver()
 {
   if( m_run_thread.joinable() )
     m_run_thread.join();
+
+  // solvers come and go during --autotune, so nothing can be left behind
+  cl.ReleaseKernel( m_kernel );
+  cl.ReleaseProgram( m_program );
+  cl.ReleaseMemObject( d_mid );
+  cl.ReleaseMemObject( d_solutions );
+  cl.ReleaseMemObject( d_solution_count );
+  cl.ReleaseCommandQueue( m_queue );
+  cl.ReleaseContext( m_context );
 }
 
 auto CLSolver::findSolution() -> void
 {
   cl_int error;
-  uint64_t target{ 0 };
+  std::shared_ptr<job_t const> job{ MinerState::getJob() };
 
   m_start = steady_clock::now();
 
   do
   {
-    if( m_new_message )
+    // midstate and target always come from the same job, so a new
+    // challenge never goes out against an old target or the reverse
+    bool const switching{ m_new_message.exchange( false ) };
+    if( m_new_target.exchange( false ) || switching )
     {
-      error = cl.EnqueueWriteBuffer( m_queue, d_mid, CL_FALSE, 0u, sizeof( state_t ), MinerState::getMidstate().data(), 0u, nullptr, nullptr );
-      m_new_message = false;
-    }
-    if( m_new_target )
-    {
-      target = MinerState::getTargetNum();
-      error = cl.SetKernelArg( m_kernel, 1u, sizeof( target ), &target );
-      m_new_target = false;
+      job = MinerState::getJob();
+      h_mid = job->midstate;
+      error = cl.EnqueueWriteBuffer( m_queue, d_mid, CL_FALSE, 0u, sizeof( h_mid ), h_mid.data(), 0u, nullptr, nullptr );
+      error = cl.SetKernelArg( m_kernel, 1u, sizeof( job->target_num ), &job->target_num );
     }
 
     h_threads = MinerState::getIncSearchSpace( m_threads );
     error = cl.SetKernelArg( m_kernel, 4, sizeof( h_threads ), &h_threads );
 
-    cl.Flush( m_queue );
-    error = cl.EnqueueNDRangeKernel( m_queue, m_kernel, 1u, nullptr, &m_global_work_size, &m_local_work_size, 0u, nullptr, nullptr );
+    // The round goes out in chunks of about CHUNK_MS, two in the queue at
+    // a time so the device never waits on us. A new message stops any
+    // more going out; the rest of the lease is simply dropped.
+    size_t const chunk_size{ chunkSize() };
+    size_t offset{ 0u };
+    cl_event in_flight{ nullptr };
+    do
+    {
+      size_t const size{ std::min<size_t>( chunk_size, m_global_work_size - offset ) };
+      cl_event done{ nullptr };
+      error = cl.EnqueueNDRangeKernel( m_queue, m_kernel, 1u, &offset, &size, &m_local_work_size, 0u, nullptr, &done );
+      cl.Flush( m_queue );
+      offset += size;
+
+      if( switching && offset == size )
+      {
+        m_switch_time.store( duration<double, std::milli>( steady_clock::now().time_since_epoch() ).count() -
+                             m_switch_start.load( std::memory_order_acquire ), std::memory_order_release );
+      }
 
-    updateHashrate();
+      if( in_flight )
+      {
+        cl.WaitForEvents( 1u, &in_flight );
+        cl.ReleaseEvent( in_flight );
+      }
+      in_flight = done;
+    }
+    while( offset < m_global_work_size && !m_new_message && !m_stop );
 
     error = cl.EnqueueReadBuffer( m_queue, d_solution_count, CL_TRUE, 0u, sizeof( h_solution_count ), &h_solution_count, 0u, nullptr, nullptr );
+    if( in_flight )
+    {
+      cl.ReleaseEvent( in_flight );
+    }
+
+    updateHashrate( offset );
+
+    // a round cut short by a new message or a stop times only part of a
+    // launch, which would drag the sizer down; only size from whole rounds
+    if( m_sizer.isEnabled() && offset == m_global_work_size )
+    {
+      m_threads = m_sizer.next( offset, m_last_launch );
+      m_global_work_size = m_threads;
+      m_intensity = std::log2( static_cast<double>( m_threads ) );
+    }
 
     if( error == CL_SUCCESS && h_solution_count > 0u )
     {
@@ -179,7 +244,7 @@ auto CLSolver::findSolution() -> void
         continue;
       }
 
-      MinerState::pushSolution( std::vector<uint64_t>{ h_solutions, h_solutions + h_solution_count } );
+      MinerState::pushSolutions( h_solutions, h_solution_count, job->epoch );
       h_solution_count = 0u;
       error = cl.EnqueueWriteBuffer( m_queue, d_solution_count, CL_FALSE, 0u, sizeof( h_solution_count ), &h_solution_count, 0u, nullptr, nullptr );
     }
@@ -189,6 +254,15 @@ auto CLSolver::findSolution() -> void
   m_device_initialized = false;
 }
 
+auto CLSolver::chunkSize() const -> size_t
+{
+  double const launch_ms{ m_launch_time.load( std::memory_order_acquire ) };
+  size_t const groups{ m_global_work_size / m_local_work_size };
+  size_t const chunks{ std::clamp<size_t>( static_cast<size_t>( std::ceil( launch_ms / CHUNK_MS ) ), 1u,
+                                           std::max<size_t>( groups, 1u ) ) };
+  return (groups + chunks - 1u) / chunks * m_local_work_size;
+}
+
 auto CLSolver::startFinding() -> void
 {
   m_run_thread = std::thread( &CLSolver::findSolution, this );
@@ -27,6 +27,7 @@
 #include "isolver.h"
 #include "types.h"
 #include "devicetelemetry.h"
+#include "launchsizer.h"
 #include "DynamicLibs/dlopencl.h"
 
 #include <cstdint>
@@ -39,7 +40,8 @@
 class CLSolver : public ISolver
 {
 public:
-  CLSolver( cl_device_id const& device, double const& intensity ) noexcept;
+  // a `work_size` of 0 uses the largest work group the kernel allows
+  CLSolver( cl_device_id const& device, double const& intensity, uint32_t const& work_size = 0u ) noexcept;
   ~CLSolver();
 
   auto findSolution() -> void final;
@@ -52,6 +54,10 @@ public:
   { return m_telemetry_handle->getName(); }
   auto inline getHashrate() -> double const final
   { return m_hash_average.load( std::memory_order_acquire ) / 1000.; }
+  auto inline getHashCount() -> uint64_t const final
+  { return m_hash_count.load( std::memory_order_relaxed ); }
+  auto inline getLaunchTime() -> double const final
+  { return m_launch_time.load( std::memory_order_acquire ); }
 
   auto inline getClockMem() const -> uint32_t const final
   { return m_telemetry_handle->getClockMem(); }
@@ -69,31 +75,49 @@ public:
   auto inline updateTarget() -> void final
   { m_new_target = true; }
   auto inline updateMessage() -> void final
-  { m_new_message = true; }
+  {
+    m_switch_start.store( std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now().time_since_epoch() ).count(), std::memory_order_release );
+    m_new_message = true;
+  }
+  auto inline getSwitchTime() -> double const final
+  { return m_switch_time.load( std::memory_order_acquire ); }
 
 private:
   CLSolver() = delete;
   CLSolver( CLSolver const& ) = delete;
   CLSolver& operator=( CLSolver const& ) = delete;
 
-  auto inline updateHashrate() -> void
+  // work items per chunk of a round, going by the last round's length
+  auto chunkSize() const -> size_t;
+
+  // `threads` is how much of the round was actually hashed, which after
+  // a new message cuts it short isn't all of it
+  auto inline updateHashrate( uint64_t const& threads ) -> void
   {
     // store duration, incremented with (m_round_end - m_round_start)
     // store total hashes
     // calculate average when queried?
     using namespace std::chrono;
 
+    m_hash_count.fetch_add( threads, std::memory_order_relaxed );
+
     // goofy, yes; but it results in timing the _entire loop_
     m_round_end = steady_clock::now() - m_start;
     temp_time = static_cast<uint64_t>((m_round_end - m_round_start).count() / 1000000);
+    m_last_launch = duration<double, std::milli>( m_round_end - m_round_start ).count();
     m_round_start = steady_clock::now() - m_start;
 
+    m_launch_time.store( m_first_round_passed
+                         ? m_launch_time.load( std::memory_order_relaxed ) * 0.95 + m_last_launch * 0.05
+                         : m_last_launch, std::memory_order_release );
+
     if( !temp_time ) { return; } // less than 1 nanosecond
 
     // gimmick the first round because the first kernel run has extra, strange overhead
     if( !m_first_round_passed )
     {
-      m_hash_average.store( (m_threads / temp_time) / 15, std::memory_order_release );
+      m_hash_average.store( (threads / temp_time) / 15, std::memory_order_release );
       m_first_round_passed = true;
       return;
     }
@@ -101,15 +125,19 @@ private:
     temp_average = m_hash_average.load( std::memory_order_acquire ) * 19 / 20;
 
     // fairly accurate, but needs work to smooth without requiring a delay
-    temp_average += (m_threads / temp_time) / 20;
+    temp_average += (threads / temp_time) / 20;
     m_hash_average.store( temp_average, std::memory_order_release );
   }
 
   std::unique_ptr<IDeviceTelemetry> m_telemetry_handle;
 
   bool m_stop;
-  bool m_new_target;
-  bool m_new_message;
+  std::atomic<bool> m_new_target;
+  std::atomic<bool> m_new_message;
+  // steady_clock time of the last updateMessage(), and how long after it
+  // the new work went out, both in ms
+  std::atomic<double> m_switch_start;
+  std::atomic<double> m_switch_time;
   bool m_device_initialized;
 
   uint32_t h_solution_count;
@@ -117,12 +145,16 @@ private:
 
   uint64_t temp_time;
   uint64_t temp_average;
-  uint64_t m_hash_count;
+  std::atomic<uint64_t> m_hash_count;
   bool m_first_round_passed;
   std::atomic<uint64_t> m_hash_average;
+  std::atomic<double> m_launch_time;
 
-  double m_intensity;
+  // log2 of m_threads, which "launch_target" moves as it goes
+  std::atomic<double> m_intensity;
   uint64_t m_threads;
+  LaunchSizer m_sizer;
+  double m_last_launch;
 
   std::thread m_run_thread;
 
@@ -140,6 +172,7 @@ private:
   cl_mem d_solution_count;
   cl_mem d_solutions;
   cl_mem d_mid;
+  midstate_t h_mid;
   uint64_t h_threads;
 
   size_t m_global_work_size;
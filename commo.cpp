@@ -28,11 +28,13 @@
 #include "types.h"
 #include "minercore.h"
 #include "ui.h"
+#include "sharedwork.h"
 #include "BigInt/BigIntegerLibrary.hh"
 #include <json.hpp>
 #include "sph_keccak.h"
 
 #include <thread>
+#include <cstring>
 #include <atomic>
 #include <chrono>
 #include <string>
@@ -61,7 +63,6 @@ namespace
   static std::atomic<bool> m_stop{ false };
   static sph_keccak256_context ctx;
   static bool m_started{ false };
-  static message_t keccak_data;
   static hash_t keccak_result;
 
   static std::array<char, CURL_ERROR_SIZE> m_errstr{ 0 };
@@ -90,10 +91,9 @@ namespace
   static json m_get_target{ { "jsonrpc"s, "2.0"s }, { "method"s, "getMinimumShareTarget"s }, { "params"s, {} }, { "id"s, "tar"s } };
   static json const m_solution_base{ { "jsonrpc"s, "2.0"s }, { "method"s, "submitShare"s }, { "params"s, {} }, { "id"s, {} } };
 
-  static auto keccak256( std::string_view const message ) -> std::string
+  static auto keccak256( message_t const& message ) -> std::string
   {
-    hexToBytes( message, keccak_data );
-    sph_keccak256( &ctx, keccak_data.data(), keccak_data.size() );
+    sph_keccak256( &ctx, message.data(), message.size() );
     sph_keccak256_close( &ctx, keccak_result.data() );
     return bytesToString( keccak_result );
   }
@@ -226,57 +226,98 @@ namespace
     }
   }
 
+  // hands what the pool last gave us to the other instances on the host
+  static auto publishState() -> void
+  {
+    auto const job{ MinerState::getJob() };
+    if( job->epoch == 0u ) { return; }
+
+    Nabiki::SharedWork::pool_job_t shared;
+    std::memcpy( shared.challenge.data(), job->message.data(), 32 );
+    std::memcpy( shared.pool_address.data(), &job->message[32], 20 );
+    shared.diff = MinerState::getCustomDiff() ? 0u : MinerState::getDiff();
+    Nabiki::SharedWork::PublishJob( shared );
+  }
+
+  // the follower's side of updateState(): the same changes, taken from
+  // whatever the leader last published
+  static auto followLeader() -> void
+  {
+    Nabiki::SharedWork::pool_job_t shared;
+    if( !Nabiki::SharedWork::ReadJob( shared ) ) { return; }
+
+    std::string const address{ bytesToString( shared.pool_address ) };
+    if( address != MinerState::getPoolAddress() )
+    {
+      MinerState::setPoolAddress( address );
+      MinerCore::updateMessage();
+    }
+    if( shared.diff > 0u && !MinerState::getCustomDiff() && shared.diff != MinerState::getDiff() )
+    {
+      MinerState::setDiff( shared.diff );
+      MinerCore::updateTarget();
+    }
+    std::string const challenge{ bytesToString( shared.challenge ) };
+    if( challenge != MinerState::getChallenge() )
+    {
+      MinerState::setChallenge( "0x"s + challenge );
+      MinerCore::updateMessage();
+    }
+  }
+
   static auto submitSolutions() -> void
   {
-    std::string prefix{ MinerState::getPrefix() };
-    std::string oldPrefix{ MinerState::getOldPrefix() };
+    std::vector<found_t> found;
+    MinerState::drainSolutions( found );
+    if( found.empty() ) { return; }
 
     json submission;
     json solParams{ 0,
                     MinerState::getAddress(),
                     0,
                     0,
-                    "0x"s + MinerState::getChallenge(),
+                    0,
                     MinerState::getCustomDiff() };
     uint_fast16_t idCount{ 0u };
 
-    BigUnsigned digestBU, target{ MinerState::getTarget() };
-    for( auto const& sol : MinerState::getAllSolutions() )
+    uint64_t const epoch{ MinerState::getJob()->epoch };
+    BigUnsigned digestBU;
+    for( auto const& sol : found )
     {
-      std::string digest{ keccak256( prefix + sol ) };
-      digestBU = BigUnsignedInABase{ digest, 16 };
+      // each solution names the job it was found for, so stale ones are
+      // known without hashing, and the rest need hashing only once
+      if( sol.job != epoch && !MinerState::getSubmitStale() )
+      {
+        Log::pushLog( "Stale solution; not submitting."s );
+        continue;
+      }
 
-      // I know, this is so incredibly ugly
-      if( digestBU > MinerState::getTarget() )
+      auto const job{ MinerState::getRecentJob( sol.job ) };
+      if( !job )
       {
-        digest = keccak256( oldPrefix + sol );
-        digestBU = BigUnsignedInABase{ digest, 16 };
-        bool submitAnyway{ false };
+        Log::pushLog( "Solution for an expired challenge; not submitting."s );
+        continue;
+      }
 
-        if( digestBU <= target )
-        {
-          if( MinerState::getSubmitStale() )
-          {
-            submitAnyway = true;
-          }
-          else
-          {
-            Log::pushLog( "Stale solution; not submitting."s );
-          }
-        }
-        else
-        {
-          Log::pushLog( "CPU verification failed."s );
-        }
+      message_t message{ job->message };
+      std::memcpy( &message[64], &sol.nonce, 8 );
+      std::string const digest{ keccak256( message ) };
+      digestBU = BigUnsignedInABase{ digest, 16 };
 
-        if( !submitAnyway )
-        {
-          continue;
-        }
+      // check against the target the solution was mined for, not whatever
+      // the pool has moved on to since
+      if( digestBU > job->target )
+      {
+        Log::pushLog( "CPU verification failed."s );
+        continue;
       }
 
-      solParams[0] = "0x"s + sol;
+      hash_t challenge;
+      std::memcpy( challenge.data(), job->message.data(), 32 );
+
+      solParams[0] = "0x"s + MinerState::formatSolution( sol.nonce );
       solParams[2] = "0x"s + digest;
+      solParams[4] = "0x"s + bytesToString( challenge );
       // subtract 1 from the calculated diff because pool software rejects GTE instead of GT
       solParams[3] = BigUnsignedInABase( (MinerState::getMaximumTarget() / digestBU) - 1, 10u );
 
@@ -327,15 +368,28 @@ namespace
   static auto netWorker() -> void
   {
     curl_easy_setopt( m_handle.get(), CURLOPT_URL, MinerState::getPoolUrl().c_str() );
-    updateState( true );
 
-    auto check_time{ steady_clock::now() + 4s };
+    // sharing work, only the leader polls the pool; anyone who takes over
+    // starts with a full update, like a fresh start
+    bool leading{ false };
+    auto check_time{ steady_clock::now() };
     do
     {
-      if( steady_clock::now() >= check_time )
+      if( Nabiki::SharedWork::IsJoined() && !Nabiki::SharedWork::IsLeader() )
       {
-        updateState();
+        leading = false;
+        followLeader();
+      }
+      else if( steady_clock::now() >= check_time || !leading )
+      {
+        updateState( !leading );
+        leading = true;
         check_time = steady_clock::now() + 4s;
+
+        if( Nabiki::SharedWork::IsJoined() )
+        {
+          publishState();
+        }
       }
 
       submitSolutions();
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpukernel.h"
+#include "midstate.h"
+#include "platforms.h"
+#include "log.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+using Nabiki::Keccak::RC;
+
+namespace
+{
+  static auto inline chi( uint64_t (&s)[25], uint_fast8_t const offset, uint64_t const (&b)[5] ) -> void
+  {
+    s[offset     ] = b[0] ^ (~b[1] & b[2]);
+    s[offset + 1u] = b[1] ^ (~b[2] & b[3]);
+    s[offset + 2u] = b[2] ^ (~b[3] & b[4]);
+    s[offset + 3u] = b[3] ^ (~b[4] & b[0]);
+    s[offset + 4u] = b[4] ^ (~b[0] & b[1]);
+  }
+
+  // one full round, reading the state from `a` and writing it to `e`; rho,
+  // pi and chi are fused so that only one row of B is ever live
+  static auto inline keccakRound( uint64_t const (&a)[25], uint64_t (&e)[25], uint64_t const rc ) -> void
+  {
+    uint64_t C[5], D[5], B[5];
+
+    C[0] = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20];
+    C[1] = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21];
+    C[2] = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22];
+    C[3] = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23];
+    C[4] = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24];
+
+    D[0] = C[4] ^ rotl64( C[1], 1 );
+    D[1] = C[0] ^ rotl64( C[2], 1 );
+    D[2] = C[1] ^ rotl64( C[3], 1 );
+    D[3] = C[2] ^ rotl64( C[4], 1 );
+    D[4] = C[3] ^ rotl64( C[0], 1 );
+
+    B[0] = a[ 0] ^ D[0];
+    B[1] = rotl64( a[ 6] ^ D[1], 44 );
+    B[2] = rotl64( a[12] ^ D[2], 43 );
+    B[3] = rotl64( a[18] ^ D[3], 21 );
+    B[4] = rotl64( a[24] ^ D[4], 14 );
+    chi( e, 0u, B );
+    e[0] ^= rc;
+
+    B[0] = rotl64( a[ 3] ^ D[3], 28 );
+    B[1] = rotl64( a[ 9] ^ D[4], 20 );
+    B[2] = rotl64( a[10] ^ D[0],  3 );
+    B[3] = rotl64( a[16] ^ D[1], 45 );
+    B[4] = rotl64( a[22] ^ D[2], 61 );
+    chi( e, 5u, B );
+
+    B[0] = rotl64( a[ 1] ^ D[1],  1 );
+    B[1] = rotl64( a[ 7] ^ D[2],  6 );
+    B[2] = rotl64( a[13] ^ D[3], 25 );
+    B[3] = rotl64( a[19] ^ D[4],  8 );
+    B[4] = rotl64( a[20] ^ D[0], 18 );
+    chi( e, 10u, B );
+
+    B[0] = rotl64( a[ 4] ^ D[4], 27 );
+    B[1] = rotl64( a[ 5] ^ D[0], 36 );
+    B[2] = rotl64( a[11] ^ D[1], 10 );
+    B[3] = rotl64( a[17] ^ D[2], 15 );
+    B[4] = rotl64( a[23] ^ D[3], 56 );
+    chi( e, 15u, B );
+
+    B[0] = rotl64( a[ 2] ^ D[2], 62 );
+    B[1] = rotl64( a[ 8] ^ D[3], 55 );
+    B[2] = rotl64( a[14] ^ D[4], 39 );
+    B[3] = rotl64( a[15] ^ D[0], 41 );
+    B[4] = rotl64( a[21] ^ D[1],  2 );
+    chi( e, 20u, B );
+  }
+
+  // the midstate is round 0 up to (but not including) chi, computed with a
+  // zeroed nonce lane; theta spreads the nonce into eleven lanes, each of
+  // which only needs the matching rotation XORed back in. One chi output
+  // per row only takes the nonce from its own lane, and comes precomputed
+  // in mid[25..29]. Every CPU kernel hard-codes this layout.
+  static_assert( Nabiki::Keccak::NONCE_ROT[ 2] == 44 && Nabiki::Keccak::NONCE_ROT[ 4] == 14 &&
+                 Nabiki::Keccak::NONCE_ROT[ 6] == 20 && Nabiki::Keccak::NONCE_ROT[ 9] == 62 &&
+                 Nabiki::Keccak::NONCE_ROT[11] ==  7 && Nabiki::Keccak::NONCE_ROT[13] ==  8 &&
+                 Nabiki::Keccak::NONCE_ROT[15] == 27 && Nabiki::Keccak::NONCE_ROT[18] == 16 &&
+                 Nabiki::Keccak::NONCE_ROT[20] == 63 && Nabiki::Keccak::NONCE_ROT[21] == 55 &&
+                 Nabiki::Keccak::NONCE_ROT[22] == 39, "nonce rotations have moved" );
+  static_assert( Nabiki::Keccak::FOLD_COLUMN[0] == 4u && Nabiki::Keccak::FOLD_COLUMN[1] == 1u &&
+                 Nabiki::Keccak::FOLD_COLUMN[2] == 3u && Nabiki::Keccak::FOLD_COLUMN[3] == 0u &&
+                 Nabiki::Keccak::FOLD_COLUMN[4] == 2u, "folded chi lanes have moved" );
+  static auto inline keccakFirst( uint64_t (&s)[25], midstate_t const& mid, uint64_t const nonce ) -> void
+  {
+    uint64_t B[5];
+
+    B[0] = mid[ 0];
+    B[1] = mid[ 1];
+    B[2] = mid[ 2] ^ rotl64( nonce, 44 );
+    B[3] = mid[ 3];
+    B[4] = mid[ 4] ^ rotl64( nonce, 14 );
+    chi( s, 0u, B );
+    s[0] ^= RC[0];
+    s[ 4] = mid[25] ^ rotl64( nonce, 14 );
+
+    B[0] = mid[ 5];
+    B[1] = mid[ 6] ^ rotl64( nonce, 20 );
+    B[2] = mid[ 7];
+    B[3] = mid[ 8];
+    B[4] = mid[ 9] ^ rotl64( nonce, 62 );
+    chi( s, 5u, B );
+    s[ 6] = mid[26] ^ rotl64( nonce, 20 );
+
+    B[0] = mid[10];
+    B[1] = mid[11] ^ rotl64( nonce,  7 );
+    B[2] = mid[12];
+    B[3] = mid[13] ^ rotl64( nonce,  8 );
+    B[4] = mid[14];
+    chi( s, 10u, B );
+    s[13] = mid[27] ^ rotl64( nonce,  8 );
+
+    B[0] = mid[15] ^ rotl64( nonce, 27 );
+    B[1] = mid[16];
+    B[2] = mid[17];
+    B[3] = mid[18] ^ rotl64( nonce, 16 );
+    B[4] = mid[19];
+    chi( s, 15u, B );
+    s[15] = mid[28] ^ rotl64( nonce, 27 );
+
+    B[0] = mid[20] ^ rotl64( nonce, 63 );
+    B[1] = mid[21] ^ rotl64( nonce, 55 );
+    B[2] = mid[22] ^ rotl64( nonce, 39 );
+    B[3] = mid[23];
+    B[4] = mid[24];
+    chi( s, 20u, B );
+    s[22] = mid[29] ^ rotl64( nonce, 39 );
+  }
+
+  // round 23 only has to produce lane 0, which depends on three lanes
+  static auto inline keccakLast( uint64_t const (&s)[25] ) -> uint64_t
+  {
+    uint64_t C[5], B[3];
+
+    C[0] = s[0] ^ s[5] ^ s[10] ^ s[15] ^ s[20];
+    C[1] = s[1] ^ s[6] ^ s[11] ^ s[16] ^ s[21];
+    C[2] = s[2] ^ s[7] ^ s[12] ^ s[17] ^ s[22];
+    C[3] = s[3] ^ s[8] ^ s[13] ^ s[18] ^ s[23];
+    C[4] = s[4] ^ s[9] ^ s[14] ^ s[19] ^ s[24];
+
+    B[0] = s[0] ^ C[4] ^ rotl64( C[1], 1 );
+    B[1] = rotl64( s[ 6] ^ C[0] ^ rotl64( C[2], 1 ), 44 );
+    B[2] = rotl64( s[12] ^ C[1] ^ rotl64( C[3], 1 ), 43 );
+
+    return B[0] ^ (~B[1] & B[2]) ^ RC[23];
+  }
+}
+
+namespace Nabiki::Keccak
+{
+  auto mineScalar( midstate_t const& mid, uint64_t const& target,
+                   uint64_t const& base, uint64_t const& count,
+                   uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    uint64_t a[25], e[25];
+
+    for( uint64_t nonce{ base }; nonce < base + count; ++nonce )
+    {
+      keccakFirst( a, mid, nonce );
+
+      // rounds 1 through 22, ping-ponging between the two state copies
+      for( uint_fast8_t round{ 1u }; round < 23u; round += 2u )
+      {
+        keccakRound( a, e, RC[round] );
+        keccakRound( e, a, RC[round + 1u] );
+      }
+
+      if( bswap64( keccakLast( a ) ) > target || sol_count >= 256u ) { continue; }
+
+      sols[sol_count++] = nonce;
+    }
+  }
+
+  // fastest first
+  static std::array constexpr kernels{
+#if defined __x86_64__ || defined _M_X64
+    kernel_t{ "avx512"sv, 8u, CPU_AVX512F, &mineAvx512 },
+    kernel_t{ "avx2"sv,   4u, CPU_AVX2,    &mineAvx2 },
+    kernel_t{ "bmi2"sv,   2u, CPU_BMI2,    &mineBmi2 },
+#elif defined __aarch64__
+    kernel_t{ "sha3"sv,   2u, CPU_SHA3,    &mineSha3 },
+    kernel_t{ "neon"sv,   2u, CPU_NEON,    &mineNeon },
+#endif // __aarch64__
+    kernel_t{ "scalar"sv, 1u, 0u,          &mineScalar },
+    // always usable, so never reached unless asked for by name
+    kernel_t{ "portable"sv, 1u, 0u,        &minePortable }
+  };
+
+  auto usableKernels() -> std::vector<kernel_t const*>
+  {
+    uint32_t const features{ GetCpuFeatures() };
+
+    std::vector<kernel_t const*> usable;
+    for( auto const& kernel : kernels )
+    {
+      if( (kernel.features & features) == kernel.features ) { usable.push_back( &kernel ); }
+    }
+    return usable;
+  }
+
+  auto selectKernel( std::string_view const name ) -> kernel_t const&
+  {
+    static kernel_t const& selected{ [&]() -> kernel_t const&
+    {
+      uint32_t const features{ GetCpuFeatures() };
+      auto const usable{ [&]( kernel_t const& kernel ) { return (kernel.features & features) == kernel.features; } };
+
+      kernel_t const* best{ &kernels.back() };
+      for( auto const& kernel : kernels )
+      {
+        if( usable( kernel ) )
+        {
+          best = &kernel;
+          break;
+        }
+      }
+
+      std::string features_str;
+      if( features & CPU_SSE2 ) { features_str += " SSE2"sv; }
+      if( features & CPU_AVX2 ) { features_str += " AVX2"sv; }
+      if( features & CPU_AVX512F ) { features_str += " AVX-512F"sv; }
+      if( features & CPU_BMI2 ) { features_str += " BMI2"sv; }
+      if( features & CPU_NEON ) { features_str += " NEON"sv; }
+      if( features & CPU_SHA3 ) { features_str += " SHA3"sv; }
+      Log::pushLog( "CPU features:"s + ( features_str.empty() ? " none"s : features_str ) + "."s );
+
+      if( name.empty() ) { return *best; }
+
+      for( auto const& kernel : kernels )
+      {
+        if( kernel.name.size() != name.size() ||
+            !std::equal( name.begin(), name.end(), kernel.name.begin(),
+                         []( char a, char b ) { return std::tolower( static_cast<uint8_t>( a ) ) == b; } ) )
+        {
+          continue;
+        }
+
+        if( usable( kernel ) ) { return kernel; }
+
+        Log::pushLog( "CPU kernel \""s + std::string( name ) + "\" is not supported on this CPU; using \""s +
+                      std::string( best->name ) + "\" instead."s );
+        return *best;
+      }
+
+      Log::pushLog( "Unknown CPU kernel \""s + std::string( name ) + "\"; using \""s +
+                    std::string( best->name ) + "\" instead."s );
+      return *best;
+    }() };
+
+    return selected;
+  }
+}
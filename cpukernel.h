@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _CPUKERNEL_H_
+#define _CPUKERNEL_H_
+
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Nabiki::Keccak
+{
+  // iota constants for all 24 rounds of keccak-f[1600]
+  inline uint64_t constexpr RC[24]{
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull,
+    0x8000000080008000ull, 0x000000000000808bull, 0x0000000080000001ull,
+    0x8000000080008081ull, 0x8000000000008009ull, 0x000000000000008aull,
+    0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+    0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull,
+    0x8000000000008003ull, 0x8000000000008002ull, 0x8000000000000080ull,
+    0x000000000000800aull, 0x800000008000000aull, 0x8000000080008081ull,
+    0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull
+  };
+
+  // Hashes `count` consecutive nonces beginning at `base`, picking up from
+  // the round-0 midstate built by MinerState::setMidstate(). Any nonce whose
+  // leading 64 digest bits do not exceed `target` is appended to `sols`,
+  // which - like the GPU solution buffers - holds at most 256 entries.
+  auto mineScalar( midstate_t const& mid, uint64_t const& target,
+                   uint64_t const& base, uint64_t const& count,
+                   uint64_t* sols, uint32_t& sol_count ) -> void;
+
+#if defined __x86_64__ || defined _M_X64
+  // As mineScalar, using AVX2 to hash four nonces at a time - one per
+  // 64-bit lane. Any remainder of `count` that doesn't fill a vector goes
+  // to mineScalar. Only call these on CPUs with the matching features.
+  auto mineAvx2( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void;
+
+  // As mineScalar, hashing a few nonces side by side in general purpose
+  // registers with the BMI1/BMI2 and-not and rotate instructions. Meant
+  // for CPUs without usable wide vectors.
+  auto mineBmi2( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void;
+
+  // As mineAvx2, using AVX-512F to hash eight nonces at a time.
+  auto mineAvx512( midstate_t const& mid, uint64_t const& target,
+                   uint64_t const& base, uint64_t const& count,
+                   uint64_t* sols, uint32_t& sol_count ) -> void;
+
+#elif defined __aarch64__
+  // As mineScalar, using NEON to hash two nonces at a time, one per 64-bit
+  // lane. Every AArch64 CPU has NEON, so this is the baseline there.
+  auto mineNeon( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void;
+
+  // As mineNeon, using the ARMv8.2 SHA3 instructions (EOR3, RAX1, XAR and
+  // BCAX), which fold most of theta, rho and chi into single operations.
+  auto mineSha3( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void;
+
+#endif // __aarch64__
+
+  // As mineScalar, built from keccak_kernel.h - the same source the OpenCL
+  // and CUDA solvers compile - so it finds exactly what they would. Never
+  // picked on its own; name it to try kernel changes on a box without a GPU.
+  auto minePortable( midstate_t const& mid, uint64_t const& target,
+                     uint64_t const& base, uint64_t const& count,
+                     uint64_t* sols, uint32_t& sol_count ) -> void;
+
+  // A scalar keccak routine generated at run time for one midstate and
+  // target, both of which it carries as immediates. Lanes the midstate
+  // pins down are folded away, and so is anything lane 0 of the digest
+  // doesn't depend on. Needs only baseline x86-64.
+  class jit_kernel_t
+  {
+  public:
+    ~jit_kernel_t();
+
+    // as mineScalar, for the midstate and target the code was built for
+    auto mine( uint64_t const& base, uint64_t const& count,
+               uint64_t* sols, uint32_t& sol_count ) const -> void;
+
+  private:
+    jit_kernel_t( void* code, size_t const& size );
+    jit_kernel_t( jit_kernel_t const& ) = delete;
+    jit_kernel_t& operator=( jit_kernel_t const& ) = delete;
+
+    friend auto buildJitKernel( midstate_t const& mid, uint64_t const& target ) -> std::shared_ptr<jit_kernel_t const>;
+
+    void* m_code;
+    size_t m_size;
+  };
+
+  // Returns nullptr if the system won't let generated code run, and
+  // always on anything but x86-64.
+  auto buildJitKernel( midstate_t const& mid, uint64_t const& target ) -> std::shared_ptr<jit_kernel_t const>;
+
+  using kernel_fn = decltype(&mineScalar);
+
+  struct kernel_t
+  {
+    std::string_view name;
+    uint64_t width;    // nonces hashed per kernel step
+    uint32_t features; // cpu_feature_t flags the kernel requires
+    kernel_fn mine;
+  };
+
+  // Every kernel this CPU can run, fastest first.
+  auto usableKernels() -> std::vector<kernel_t const*>;
+
+  // Returns the kernel named by `name` if this CPU can run it, otherwise
+  // the fastest one it can. The choice is made once, on the first call,
+  // so every CPU solver ends up on the same kernel.
+  auto selectKernel( std::string_view const name ) -> kernel_t const&;
+}
+
+#endif // !_CPUKERNEL_H_
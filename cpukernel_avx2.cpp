@@ -0,0 +1,243 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined __x86_64__ || defined _M_X64
+
+#include "cpukernel.h"
+
+#include <cstdint>
+#include <immintrin.h>
+
+// this whole file is built for AVX2 regardless of the baseline target;
+// selectKernel() only hands the kernel out on CPUs that support it
+#if defined __clang__
+#  pragma clang attribute push( __attribute__((target("avx2"))), apply_to = function )
+#elif defined __GNUC__
+#  pragma GCC push_options
+#  pragma GCC target( "avx2" )
+#endif // __GNUC__
+
+using Nabiki::Keccak::RC;
+
+namespace
+{
+  // AVX2 has no 64-bit rotate, so it takes a shift pair
+  template<int N>
+  static auto inline rotl( __m256i const x ) -> __m256i
+  {
+    return _mm256_or_si256( _mm256_slli_epi64( x, N ), _mm256_srli_epi64( x, 64 - N ) );
+  }
+
+  static auto inline xor5( __m256i const a, __m256i const b, __m256i const c, __m256i const d, __m256i const e ) -> __m256i
+  {
+    return _mm256_xor_si256( _mm256_xor_si256( _mm256_xor_si256( a, b ), _mm256_xor_si256( c, d ) ), e );
+  }
+
+  static auto inline chi( __m256i (&s)[25], uint_fast8_t const offset, __m256i const (&b)[5] ) -> void
+  {
+    s[offset     ] = _mm256_xor_si256( b[0], _mm256_andnot_si256( b[1], b[2] ) );
+    s[offset + 1u] = _mm256_xor_si256( b[1], _mm256_andnot_si256( b[2], b[3] ) );
+    s[offset + 2u] = _mm256_xor_si256( b[2], _mm256_andnot_si256( b[3], b[4] ) );
+    s[offset + 3u] = _mm256_xor_si256( b[3], _mm256_andnot_si256( b[4], b[0] ) );
+    s[offset + 4u] = _mm256_xor_si256( b[4], _mm256_andnot_si256( b[0], b[1] ) );
+  }
+
+  static auto inline keccakRound( __m256i const (&a)[25], __m256i (&e)[25], uint64_t const rc ) -> void
+  {
+    __m256i C[5], D[5], B[5];
+
+    C[0] = xor5( a[0], a[5], a[10], a[15], a[20] );
+    C[1] = xor5( a[1], a[6], a[11], a[16], a[21] );
+    C[2] = xor5( a[2], a[7], a[12], a[17], a[22] );
+    C[3] = xor5( a[3], a[8], a[13], a[18], a[23] );
+    C[4] = xor5( a[4], a[9], a[14], a[19], a[24] );
+
+    D[0] = _mm256_xor_si256( C[4], rotl<1>( C[1] ) );
+    D[1] = _mm256_xor_si256( C[0], rotl<1>( C[2] ) );
+    D[2] = _mm256_xor_si256( C[1], rotl<1>( C[3] ) );
+    D[3] = _mm256_xor_si256( C[2], rotl<1>( C[4] ) );
+    D[4] = _mm256_xor_si256( C[3], rotl<1>( C[0] ) );
+
+    B[0] = _mm256_xor_si256( a[ 0], D[0] );
+    B[1] = rotl<44>( _mm256_xor_si256( a[ 6], D[1] ) );
+    B[2] = rotl<43>( _mm256_xor_si256( a[12], D[2] ) );
+    B[3] = rotl<21>( _mm256_xor_si256( a[18], D[3] ) );
+    B[4] = rotl<14>( _mm256_xor_si256( a[24], D[4] ) );
+    chi( e, 0u, B );
+    e[0] = _mm256_xor_si256( e[0], _mm256_set1_epi64x( static_cast<int64_t>(rc) ) );
+
+    B[0] = rotl<28>( _mm256_xor_si256( a[ 3], D[3] ) );
+    B[1] = rotl<20>( _mm256_xor_si256( a[ 9], D[4] ) );
+    B[2] = rotl< 3>( _mm256_xor_si256( a[10], D[0] ) );
+    B[3] = rotl<45>( _mm256_xor_si256( a[16], D[1] ) );
+    B[4] = rotl<61>( _mm256_xor_si256( a[22], D[2] ) );
+    chi( e, 5u, B );
+
+    B[0] = rotl< 1>( _mm256_xor_si256( a[ 1], D[1] ) );
+    B[1] = rotl< 6>( _mm256_xor_si256( a[ 7], D[2] ) );
+    B[2] = rotl<25>( _mm256_xor_si256( a[13], D[3] ) );
+    B[3] = rotl< 8>( _mm256_xor_si256( a[19], D[4] ) );
+    B[4] = rotl<18>( _mm256_xor_si256( a[20], D[0] ) );
+    chi( e, 10u, B );
+
+    B[0] = rotl<27>( _mm256_xor_si256( a[ 4], D[4] ) );
+    B[1] = rotl<36>( _mm256_xor_si256( a[ 5], D[0] ) );
+    B[2] = rotl<10>( _mm256_xor_si256( a[11], D[1] ) );
+    B[3] = rotl<15>( _mm256_xor_si256( a[17], D[2] ) );
+    B[4] = rotl<56>( _mm256_xor_si256( a[23], D[3] ) );
+    chi( e, 15u, B );
+
+    B[0] = rotl<62>( _mm256_xor_si256( a[ 2], D[2] ) );
+    B[1] = rotl<55>( _mm256_xor_si256( a[ 8], D[3] ) );
+    B[2] = rotl<39>( _mm256_xor_si256( a[14], D[4] ) );
+    B[3] = rotl<41>( _mm256_xor_si256( a[15], D[0] ) );
+    B[4] = rotl< 2>( _mm256_xor_si256( a[21], D[1] ) );
+    chi( e, 20u, B );
+  }
+
+  static auto inline keccakFirst( __m256i (&s)[25], __m256i const (&mid)[30], __m256i const nonce ) -> void
+  {
+    __m256i B[5];
+
+    B[0] = mid[ 0];
+    B[1] = mid[ 1];
+    B[2] = _mm256_xor_si256( mid[ 2], rotl<44>( nonce ) );
+    B[3] = mid[ 3];
+    B[4] = _mm256_xor_si256( mid[ 4], rotl<14>( nonce ) );
+    chi( s, 0u, B );
+    s[0] = _mm256_xor_si256( s[0], _mm256_set1_epi64x( static_cast<int64_t>(RC[0]) ) );
+    s[ 4] = _mm256_xor_si256( mid[25], rotl<14>( nonce ) );
+
+    B[0] = mid[ 5];
+    B[1] = _mm256_xor_si256( mid[ 6], rotl<20>( nonce ) );
+    B[2] = mid[ 7];
+    B[3] = mid[ 8];
+    B[4] = _mm256_xor_si256( mid[ 9], rotl<62>( nonce ) );
+    chi( s, 5u, B );
+    s[ 6] = _mm256_xor_si256( mid[26], rotl<20>( nonce ) );
+
+    B[0] = mid[10];
+    B[1] = _mm256_xor_si256( mid[11], rotl< 7>( nonce ) );
+    B[2] = mid[12];
+    B[3] = _mm256_xor_si256( mid[13], rotl< 8>( nonce ) );
+    B[4] = mid[14];
+    chi( s, 10u, B );
+    s[13] = _mm256_xor_si256( mid[27], rotl< 8>( nonce ) );
+
+    B[0] = _mm256_xor_si256( mid[15], rotl<27>( nonce ) );
+    B[1] = mid[16];
+    B[2] = mid[17];
+    B[3] = _mm256_xor_si256( mid[18], rotl<16>( nonce ) );
+    B[4] = mid[19];
+    chi( s, 15u, B );
+    s[15] = _mm256_xor_si256( mid[28], rotl<27>( nonce ) );
+
+    B[0] = _mm256_xor_si256( mid[20], rotl<63>( nonce ) );
+    B[1] = _mm256_xor_si256( mid[21], rotl<55>( nonce ) );
+    B[2] = _mm256_xor_si256( mid[22], rotl<39>( nonce ) );
+    B[3] = mid[23];
+    B[4] = mid[24];
+    chi( s, 20u, B );
+    s[22] = _mm256_xor_si256( mid[29], rotl<39>( nonce ) );
+  }
+
+  static auto inline keccakLast( __m256i const (&s)[25] ) -> __m256i
+  {
+    __m256i C[5], B[3];
+
+    C[0] = xor5( s[0], s[5], s[10], s[15], s[20] );
+    C[1] = xor5( s[1], s[6], s[11], s[16], s[21] );
+    C[2] = xor5( s[2], s[7], s[12], s[17], s[22] );
+    C[3] = xor5( s[3], s[8], s[13], s[18], s[23] );
+    C[4] = xor5( s[4], s[9], s[14], s[19], s[24] );
+
+    B[0] = _mm256_xor_si256( _mm256_xor_si256( s[0], C[4] ), rotl<1>( C[1] ) );
+    B[1] = rotl<44>( _mm256_xor_si256( _mm256_xor_si256( s[ 6], C[0] ), rotl<1>( C[2] ) ) );
+    B[2] = rotl<43>( _mm256_xor_si256( _mm256_xor_si256( s[12], C[1] ), rotl<1>( C[3] ) ) );
+
+    return _mm256_xor_si256( _mm256_xor_si256( B[0], _mm256_andnot_si256( B[1], B[2] ) ),
+                             _mm256_set1_epi64x( static_cast<int64_t>(RC[23]) ) );
+  }
+}
+
+namespace Nabiki::Keccak
+{
+  auto mineAvx2( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    // byte-reverses each 64-bit lane, making the digest prefix big-endian
+    __m256i const bswap{ _mm256_set_epi8( 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 ) };
+    // AVX2 only compares signed lanes; flipping the sign bit of both sides
+    // gives the unsigned ordering
+    __m256i const sign{ _mm256_set1_epi64x( INT64_MIN ) };
+    __m256i const v_target{ _mm256_xor_si256( _mm256_set1_epi64x( static_cast<int64_t>(target) ), sign ) };
+    __m256i const step{ _mm256_set1_epi64x( 4 ) };
+
+    __m256i v_mid[30], a[25], e[25];
+    for( uint_fast8_t i{ 0u }; i < 30u; ++i )
+    {
+      v_mid[i] = _mm256_set1_epi64x( static_cast<int64_t>(mid[i]) );
+    }
+
+    uint64_t const vec_count{ count & ~3ull };
+    __m256i nonce{ _mm256_add_epi64( _mm256_set1_epi64x( static_cast<int64_t>(base) ),
+                                     _mm256_set_epi64x( 3, 2, 1, 0 ) ) };
+
+    for( uint64_t i{ 0u }; i < vec_count; i += 4u, nonce = _mm256_add_epi64( nonce, step ) )
+    {
+      keccakFirst( a, v_mid, nonce );
+
+      for( uint_fast8_t round{ 1u }; round < 23u; round += 2u )
+      {
+        keccakRound( a, e, RC[round] );
+        keccakRound( e, a, RC[round + 1u] );
+      }
+
+      __m256i const digest{ _mm256_xor_si256( _mm256_shuffle_epi8( keccakLast( a ), bswap ), sign ) };
+      int32_t const above{ _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( digest, v_target ) ) ) };
+      if( above == 0xf ) { continue; }
+
+      for( uint_fast8_t lane{ 0u }; lane < 4u; ++lane )
+      {
+        if( (above >> lane) & 1 || sol_count >= 256u ) { continue; }
+
+        sols[sol_count++] = base + i + lane;
+      }
+    }
+
+    if( vec_count < count )
+    {
+      mineScalar( mid, target, base + vec_count, count - vec_count, sols, sol_count );
+    }
+  }
+}
+
+#if defined __clang__
+#  pragma clang attribute pop
+#elif defined __GNUC__
+#  pragma GCC pop_options
+#endif // __GNUC__
+
+#endif // __x86_64__
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined __x86_64__ || defined _M_X64
+
+#include "cpukernel.h"
+
+#include <cstdint>
+#include <immintrin.h>
+
+// this whole file is built for AVX-512F regardless of the baseline target;
+// selectKernel() only hands the kernel out on CPUs that support it
+#if defined __clang__
+#  pragma clang attribute push( __attribute__((target("avx512f"))), apply_to = function )
+#elif defined __GNUC__
+#  pragma GCC push_options
+#  pragma GCC target( "avx512f" )
+#endif // __GNUC__
+
+using Nabiki::Keccak::RC;
+
+namespace
+{
+  // vpternlogq truth tables
+  int32_t constexpr XOR3{ 0x96 };   // a ^ b ^ c
+  int32_t constexpr CHI{ 0xd2 };    // a ^ (~b & c)
+  int32_t constexpr SELECT{ 0xd8 }; // c ? b : a
+
+  // all-lanes masks: GCC's unmasked shift/rotate helpers pass an undefined
+  // vector as the merge operand and -Wuninitialized trips over it, so use the
+  // zero-masking forms, which compile to the same unmasked instructions
+  __mmask8 constexpr ALL{ 0xff };
+  __mmask16 constexpr ALL_32{ 0xffff };
+
+  static auto inline xor3( __m512i const a, __m512i const b, __m512i const c ) -> __m512i
+  {
+    return _mm512_ternarylogic_epi64( a, b, c, XOR3 );
+  }
+
+  static auto inline xor5( __m512i const a, __m512i const b, __m512i const c, __m512i const d, __m512i const e ) -> __m512i
+  {
+    return xor3( xor3( a, b, c ), d, e );
+  }
+
+  static auto inline chi( __m512i (&s)[25], uint_fast8_t const offset, __m512i const (&b)[5] ) -> void
+  {
+    s[offset     ] = _mm512_ternarylogic_epi64( b[0], b[1], b[2], CHI );
+    s[offset + 1u] = _mm512_ternarylogic_epi64( b[1], b[2], b[3], CHI );
+    s[offset + 2u] = _mm512_ternarylogic_epi64( b[2], b[3], b[4], CHI );
+    s[offset + 3u] = _mm512_ternarylogic_epi64( b[3], b[4], b[0], CHI );
+    s[offset + 4u] = _mm512_ternarylogic_epi64( b[4], b[0], b[1], CHI );
+  }
+
+  // theta's column term for lane x is C[x-1] ^ rotl(C[x+1], 1); with R
+  // holding the rotated parities, each lane takes a single vpternlogq
+  static auto inline keccakRound( __m512i const (&a)[25], __m512i (&e)[25], uint64_t const rc ) -> void
+  {
+    __m512i C[5], R[5], B[5];
+
+    C[0] = xor5( a[0], a[5], a[10], a[15], a[20] );
+    C[1] = xor5( a[1], a[6], a[11], a[16], a[21] );
+    C[2] = xor5( a[2], a[7], a[12], a[17], a[22] );
+    C[3] = xor5( a[3], a[8], a[13], a[18], a[23] );
+    C[4] = xor5( a[4], a[9], a[14], a[19], a[24] );
+
+    R[0] = _mm512_maskz_rol_epi64( ALL, C[0], 1 );
+    R[1] = _mm512_maskz_rol_epi64( ALL, C[1], 1 );
+    R[2] = _mm512_maskz_rol_epi64( ALL, C[2], 1 );
+    R[3] = _mm512_maskz_rol_epi64( ALL, C[3], 1 );
+    R[4] = _mm512_maskz_rol_epi64( ALL, C[4], 1 );
+
+    B[0] = xor3( a[ 0], C[4], R[1] );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 6], C[0], R[2] ), 44 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( a[12], C[1], R[3] ), 43 );
+    B[3] = _mm512_maskz_rol_epi64( ALL, xor3( a[18], C[2], R[4] ), 21 );
+    B[4] = _mm512_maskz_rol_epi64( ALL, xor3( a[24], C[3], R[0] ), 14 );
+    chi( e, 0u, B );
+    e[0] = _mm512_xor_si512( e[0], _mm512_set1_epi64( static_cast<int64_t>(rc) ) );
+
+    B[0] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 3], C[2], R[4] ), 28 );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 9], C[3], R[0] ), 20 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( a[10], C[4], R[1] ),  3 );
+    B[3] = _mm512_maskz_rol_epi64( ALL, xor3( a[16], C[0], R[2] ), 45 );
+    B[4] = _mm512_maskz_rol_epi64( ALL, xor3( a[22], C[1], R[3] ), 61 );
+    chi( e, 5u, B );
+
+    B[0] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 1], C[0], R[2] ),  1 );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 7], C[1], R[3] ),  6 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( a[13], C[2], R[4] ), 25 );
+    B[3] = _mm512_maskz_rol_epi64( ALL, xor3( a[19], C[3], R[0] ),  8 );
+    B[4] = _mm512_maskz_rol_epi64( ALL, xor3( a[20], C[4], R[1] ), 18 );
+    chi( e, 10u, B );
+
+    B[0] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 4], C[3], R[0] ), 27 );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 5], C[4], R[1] ), 36 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( a[11], C[0], R[2] ), 10 );
+    B[3] = _mm512_maskz_rol_epi64( ALL, xor3( a[17], C[1], R[3] ), 15 );
+    B[4] = _mm512_maskz_rol_epi64( ALL, xor3( a[23], C[2], R[4] ), 56 );
+    chi( e, 15u, B );
+
+    B[0] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 2], C[1], R[3] ), 62 );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( a[ 8], C[2], R[4] ), 55 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( a[14], C[3], R[0] ), 39 );
+    B[3] = _mm512_maskz_rol_epi64( ALL, xor3( a[15], C[4], R[1] ), 41 );
+    B[4] = _mm512_maskz_rol_epi64( ALL, xor3( a[21], C[0], R[2] ),  2 );
+    chi( e, 20u, B );
+  }
+
+  static auto inline keccakFirst( __m512i (&s)[25], __m512i const (&mid)[30], __m512i const nonce ) -> void
+  {
+    __m512i B[5];
+
+    B[0] = mid[ 0];
+    B[1] = mid[ 1];
+    B[2] = _mm512_xor_si512( mid[ 2], _mm512_maskz_rol_epi64( ALL, nonce, 44 ) );
+    B[3] = mid[ 3];
+    B[4] = _mm512_xor_si512( mid[ 4], _mm512_maskz_rol_epi64( ALL, nonce, 14 ) );
+    chi( s, 0u, B );
+    s[0] = _mm512_xor_si512( s[0], _mm512_set1_epi64( static_cast<int64_t>(RC[0]) ) );
+    s[ 4] = _mm512_xor_si512( mid[25], _mm512_maskz_rol_epi64( ALL, nonce, 14 ) );
+
+    B[0] = mid[ 5];
+    B[1] = _mm512_xor_si512( mid[ 6], _mm512_maskz_rol_epi64( ALL, nonce, 20 ) );
+    B[2] = mid[ 7];
+    B[3] = mid[ 8];
+    B[4] = _mm512_xor_si512( mid[ 9], _mm512_maskz_rol_epi64( ALL, nonce, 62 ) );
+    chi( s, 5u, B );
+    s[ 6] = _mm512_xor_si512( mid[26], _mm512_maskz_rol_epi64( ALL, nonce, 20 ) );
+
+    B[0] = mid[10];
+    B[1] = _mm512_xor_si512( mid[11], _mm512_maskz_rol_epi64( ALL, nonce,  7 ) );
+    B[2] = mid[12];
+    B[3] = _mm512_xor_si512( mid[13], _mm512_maskz_rol_epi64( ALL, nonce,  8 ) );
+    B[4] = mid[14];
+    chi( s, 10u, B );
+    s[13] = _mm512_xor_si512( mid[27], _mm512_maskz_rol_epi64( ALL, nonce,  8 ) );
+
+    B[0] = _mm512_xor_si512( mid[15], _mm512_maskz_rol_epi64( ALL, nonce, 27 ) );
+    B[1] = mid[16];
+    B[2] = mid[17];
+    B[3] = _mm512_xor_si512( mid[18], _mm512_maskz_rol_epi64( ALL, nonce, 16 ) );
+    B[4] = mid[19];
+    chi( s, 15u, B );
+    s[15] = _mm512_xor_si512( mid[28], _mm512_maskz_rol_epi64( ALL, nonce, 27 ) );
+
+    B[0] = _mm512_xor_si512( mid[20], _mm512_maskz_rol_epi64( ALL, nonce, 63 ) );
+    B[1] = _mm512_xor_si512( mid[21], _mm512_maskz_rol_epi64( ALL, nonce, 55 ) );
+    B[2] = _mm512_xor_si512( mid[22], _mm512_maskz_rol_epi64( ALL, nonce, 39 ) );
+    B[3] = mid[23];
+    B[4] = mid[24];
+    chi( s, 20u, B );
+    s[22] = _mm512_xor_si512( mid[29], _mm512_maskz_rol_epi64( ALL, nonce, 39 ) );
+  }
+
+  static auto inline keccakLast( __m512i const (&s)[25] ) -> __m512i
+  {
+    __m512i C[5], B[3];
+
+    C[0] = xor5( s[0], s[5], s[10], s[15], s[20] );
+    C[1] = xor5( s[1], s[6], s[11], s[16], s[21] );
+    C[2] = xor5( s[2], s[7], s[12], s[17], s[22] );
+    C[3] = xor5( s[3], s[8], s[13], s[18], s[23] );
+    C[4] = xor5( s[4], s[9], s[14], s[19], s[24] );
+
+    B[0] = xor3( s[0], C[4], _mm512_maskz_rol_epi64( ALL, C[1], 1 ) );
+    B[1] = _mm512_maskz_rol_epi64( ALL, xor3( s[ 6], C[0], _mm512_maskz_rol_epi64( ALL, C[2], 1 ) ), 44 );
+    B[2] = _mm512_maskz_rol_epi64( ALL, xor3( s[12], C[1], _mm512_maskz_rol_epi64( ALL, C[3], 1 ) ), 43 );
+
+    return _mm512_xor_si512( _mm512_ternarylogic_epi64( B[0], B[1], B[2], CHI ),
+                             _mm512_set1_epi64( static_cast<int64_t>(RC[23]) ) );
+  }
+
+  // vpshufb on zmm needs AVX512BW, so swap halves, then words, then bytes
+  static auto inline bswap( __m512i const x ) -> __m512i
+  {
+    __m512i const t{ _mm512_maskz_rol_epi32( ALL_32, _mm512_maskz_rol_epi64( ALL, x, 32 ), 16 ) };
+    return _mm512_ternarylogic_epi64( _mm512_maskz_slli_epi64( ALL, t, 8 ),
+                                      _mm512_maskz_srli_epi64( ALL, t, 8 ),
+                                      _mm512_set1_epi64( 0x00ff00ff00ff00ffll ), SELECT );
+  }
+}
+
+namespace Nabiki::Keccak
+{
+  auto mineAvx512( midstate_t const& mid, uint64_t const& target,
+                   uint64_t const& base, uint64_t const& count,
+                   uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    __m512i const v_target{ _mm512_set1_epi64( static_cast<int64_t>(target) ) };
+    __m512i const step{ _mm512_set1_epi64( 8 ) };
+
+    __m512i v_mid[30], a[25], e[25];
+    for( uint_fast8_t i{ 0u }; i < 30u; ++i )
+    {
+      v_mid[i] = _mm512_set1_epi64( static_cast<int64_t>(mid[i]) );
+    }
+
+    uint64_t const vec_count{ count & ~7ull };
+    __m512i nonce{ _mm512_add_epi64( _mm512_set1_epi64( static_cast<int64_t>(base) ),
+                                     _mm512_set_epi64( 7, 6, 5, 4, 3, 2, 1, 0 ) ) };
+
+    for( uint64_t i{ 0u }; i < vec_count; i += 8u, nonce = _mm512_add_epi64( nonce, step ) )
+    {
+      keccakFirst( a, v_mid, nonce );
+
+      for( uint_fast8_t round{ 1u }; round < 23u; round += 2u )
+      {
+        keccakRound( a, e, RC[round] );
+        keccakRound( e, a, RC[round + 1u] );
+      }
+
+      __mmask8 const below{ _mm512_cmple_epu64_mask( bswap( keccakLast( a ) ), v_target ) };
+      if( !below ) { continue; }
+
+      for( uint_fast8_t lane{ 0u }; lane < 8u; ++lane )
+      {
+        if( !((below >> lane) & 1) || sol_count >= 256u ) { continue; }
+
+        sols[sol_count++] = base + i + lane;
+      }
+    }
+
+    if( vec_count < count )
+    {
+      mineScalar( mid, target, base + vec_count, count - vec_count, sols, sol_count );
+    }
+  }
+}
+
+#if defined __clang__
+#  pragma clang attribute pop
+#elif defined __GNUC__
+#  pragma GCC pop_options
+#endif // __GNUC__
+
+#endif // __x86_64__
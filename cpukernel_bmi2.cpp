@@ -0,0 +1,309 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined __x86_64__ || defined _M_X64
+
+#include "cpukernel.h"
+#include "platforms.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// BMI2 gives a non-destructive rotate (rorx) and BMI1 a fused and-not
+// (andn), which between them take a good share of the moves and NOTs out
+// of a round. This file is always built with both, and selectKernel() only
+// hands the kernel out on CPUs that have them.
+#if defined __clang__
+#  pragma clang attribute push( __attribute__((target("bmi,bmi2"))), apply_to = function )
+#elif defined __GNUC__
+#  pragma GCC push_options
+#  pragma GCC target( "bmi,bmi2" )
+// left to itself, GCC packs pairs of lanes into SSE2 registers, which have
+// neither instruction and end up slower than the plain scalar kernel
+#  pragma GCC optimize( "no-tree-vectorize" )
+#endif // __GNUC__
+
+using Nabiki::Keccak::RC;
+
+namespace
+{
+  // A group of N independent nonces, each in a general purpose register.
+  // One round of a single nonce is a long chain of dependent operations;
+  // hashing several at once, with every step done for each in turn, gives
+  // the out-of-order core independent work to fill its ports with.
+  // two was measurably faster than one, three or four; past that the
+  // state no longer fits anywhere near the register file
+  static size_t constexpr LANES{ 2u };
+
+  template<size_t N>
+  struct lanes_t
+  {
+    uint64_t v[N];
+  };
+
+  // calls f( 0 ) ... f( N - 1 ) as straight-line code; a plain loop over
+  // the lanes isn't reliably unrolled once the round is this large
+  template<typename F, size_t... I>
+  static auto inline forEach( F&& f, std::index_sequence<I...> ) -> void
+  {
+    ( f( I ), ... );
+  }
+
+  template<size_t N>
+  static auto inline splat( uint64_t const x ) -> lanes_t<N>
+  {
+    lanes_t<N> r;
+    forEach( [&]( size_t const i ) { r.v[i] = x; }, std::make_index_sequence<N>{} );
+    return r;
+  }
+
+  template<size_t N>
+  static auto inline operator^( lanes_t<N> const& a, lanes_t<N> const& b ) -> lanes_t<N>
+  {
+    lanes_t<N> r;
+    forEach( [&]( size_t const i ) { r.v[i] = a.v[i] ^ b.v[i]; }, std::make_index_sequence<N>{} );
+    return r;
+  }
+
+  template<size_t N>
+  static auto inline operator^( lanes_t<N> const& a, uint64_t const b ) -> lanes_t<N>
+  {
+    lanes_t<N> r;
+    forEach( [&]( size_t const i ) { r.v[i] = a.v[i] ^ b; }, std::make_index_sequence<N>{} );
+    return r;
+  }
+
+  template<size_t N>
+  static auto inline operator^=( lanes_t<N>& a, uint64_t const b ) -> lanes_t<N>&
+  {
+    forEach( [&]( size_t const i ) { a.v[i] ^= b; }, std::make_index_sequence<N>{} );
+    return a;
+  }
+
+  // ~a & b, a single andn
+  template<size_t N>
+  static auto inline andn( lanes_t<N> const& a, lanes_t<N> const& b ) -> lanes_t<N>
+  {
+    lanes_t<N> r;
+    forEach( [&]( size_t const i ) { r.v[i] = ~a.v[i] & b.v[i]; }, std::make_index_sequence<N>{} );
+    return r;
+  }
+
+  // the shift pair is recognised as a rotate, and emitted as rorx
+  template<int R, size_t N>
+  static auto inline rotl( lanes_t<N> const& x ) -> lanes_t<N>
+  {
+    lanes_t<N> r;
+    forEach( [&]( size_t const i ) { r.v[i] = x.v[i] << R | x.v[i] >> (64 - R); }, std::make_index_sequence<N>{} );
+    return r;
+  }
+
+  template<size_t N>
+  static auto inline chi( lanes_t<N> (&s)[25], uint_fast8_t const offset, lanes_t<N> const (&b)[5] ) -> void
+  {
+    s[offset     ] = b[0] ^ andn( b[1], b[2] );
+    s[offset + 1u] = b[1] ^ andn( b[2], b[3] );
+    s[offset + 2u] = b[2] ^ andn( b[3], b[4] );
+    s[offset + 3u] = b[3] ^ andn( b[4], b[0] );
+    s[offset + 4u] = b[4] ^ andn( b[0], b[1] );
+  }
+
+  // one full round, reading the state from `a` and writing it to `e`; rho,
+  // pi and chi are fused so that only one row of B is ever live
+  template<size_t N>
+  static auto inline keccakRound( lanes_t<N> const (&a)[25], lanes_t<N> (&e)[25], uint64_t const rc ) -> void
+  {
+    lanes_t<N> C[5], D[5], B[5];
+
+    C[0] = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20];
+    C[1] = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21];
+    C[2] = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22];
+    C[3] = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23];
+    C[4] = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24];
+
+    D[0] = C[4] ^ rotl<1>( C[1] );
+    D[1] = C[0] ^ rotl<1>( C[2] );
+    D[2] = C[1] ^ rotl<1>( C[3] );
+    D[3] = C[2] ^ rotl<1>( C[4] );
+    D[4] = C[3] ^ rotl<1>( C[0] );
+
+    B[0] = a[ 0] ^ D[0];
+    B[1] = rotl<44>( a[ 6] ^ D[1] );
+    B[2] = rotl<43>( a[12] ^ D[2] );
+    B[3] = rotl<21>( a[18] ^ D[3] );
+    B[4] = rotl<14>( a[24] ^ D[4] );
+    chi( e, 0u, B );
+    e[0] ^= rc;
+
+    B[0] = rotl<28>( a[ 3] ^ D[3] );
+    B[1] = rotl<20>( a[ 9] ^ D[4] );
+    B[2] = rotl<3>( a[10] ^ D[0] );
+    B[3] = rotl<45>( a[16] ^ D[1] );
+    B[4] = rotl<61>( a[22] ^ D[2] );
+    chi( e, 5u, B );
+
+    B[0] = rotl<1>( a[ 1] ^ D[1] );
+    B[1] = rotl<6>( a[ 7] ^ D[2] );
+    B[2] = rotl<25>( a[13] ^ D[3] );
+    B[3] = rotl<8>( a[19] ^ D[4] );
+    B[4] = rotl<18>( a[20] ^ D[0] );
+    chi( e, 10u, B );
+
+    B[0] = rotl<27>( a[ 4] ^ D[4] );
+    B[1] = rotl<36>( a[ 5] ^ D[0] );
+    B[2] = rotl<10>( a[11] ^ D[1] );
+    B[3] = rotl<15>( a[17] ^ D[2] );
+    B[4] = rotl<56>( a[23] ^ D[3] );
+    chi( e, 15u, B );
+
+    B[0] = rotl<62>( a[ 2] ^ D[2] );
+    B[1] = rotl<55>( a[ 8] ^ D[3] );
+    B[2] = rotl<39>( a[14] ^ D[4] );
+    B[3] = rotl<41>( a[15] ^ D[0] );
+    B[4] = rotl<2>( a[21] ^ D[1] );
+    chi( e, 20u, B );
+  }
+
+  // the midstate is round 0 up to (but not including) chi, computed with a
+  // zeroed nonce lane; theta spreads the nonce into eleven lanes, each of
+  // which only needs the matching rotation XORed back in
+  template<size_t N>
+  static auto inline keccakFirst( lanes_t<N> (&s)[25], midstate_t const& mid, lanes_t<N> const nonce ) -> void
+  {
+    lanes_t<N> B[5];
+
+    B[0] = splat<N>( mid[ 0] );
+    B[1] = splat<N>( mid[ 1] );
+    B[2] = splat<N>( mid[ 2] ) ^ rotl<44>( nonce );
+    B[3] = splat<N>( mid[ 3] );
+    B[4] = splat<N>( mid[ 4] ) ^ rotl<14>( nonce );
+    chi( s, 0u, B );
+    s[0] ^= RC[0];
+    s[ 4] = splat<N>( mid[25] ) ^ rotl<14>( nonce );
+
+    B[0] = splat<N>( mid[ 5] );
+    B[1] = splat<N>( mid[ 6] ) ^ rotl<20>( nonce );
+    B[2] = splat<N>( mid[ 7] );
+    B[3] = splat<N>( mid[ 8] );
+    B[4] = splat<N>( mid[ 9] ) ^ rotl<62>( nonce );
+    chi( s, 5u, B );
+    s[ 6] = splat<N>( mid[26] ) ^ rotl<20>( nonce );
+
+    B[0] = splat<N>( mid[10] );
+    B[1] = splat<N>( mid[11] ) ^ rotl<7>( nonce );
+    B[2] = splat<N>( mid[12] );
+    B[3] = splat<N>( mid[13] ) ^ rotl<8>( nonce );
+    B[4] = splat<N>( mid[14] );
+    chi( s, 10u, B );
+    s[13] = splat<N>( mid[27] ) ^ rotl<8>( nonce );
+
+    B[0] = splat<N>( mid[15] ) ^ rotl<27>( nonce );
+    B[1] = splat<N>( mid[16] );
+    B[2] = splat<N>( mid[17] );
+    B[3] = splat<N>( mid[18] ) ^ rotl<16>( nonce );
+    B[4] = splat<N>( mid[19] );
+    chi( s, 15u, B );
+    s[15] = splat<N>( mid[28] ) ^ rotl<27>( nonce );
+
+    B[0] = splat<N>( mid[20] ) ^ rotl<63>( nonce );
+    B[1] = splat<N>( mid[21] ) ^ rotl<55>( nonce );
+    B[2] = splat<N>( mid[22] ) ^ rotl<39>( nonce );
+    B[3] = splat<N>( mid[23] );
+    B[4] = splat<N>( mid[24] );
+    chi( s, 20u, B );
+    s[22] = splat<N>( mid[29] ) ^ rotl<39>( nonce );
+  }
+
+  // round 23 only has to produce lane 0, which depends on three lanes
+  template<size_t N>
+  static auto inline keccakLast( lanes_t<N> const (&s)[25] ) -> lanes_t<N>
+  {
+    lanes_t<N> C[5], B[3];
+
+    C[0] = s[0] ^ s[5] ^ s[10] ^ s[15] ^ s[20];
+    C[1] = s[1] ^ s[6] ^ s[11] ^ s[16] ^ s[21];
+    C[2] = s[2] ^ s[7] ^ s[12] ^ s[17] ^ s[22];
+    C[3] = s[3] ^ s[8] ^ s[13] ^ s[18] ^ s[23];
+    C[4] = s[4] ^ s[9] ^ s[14] ^ s[19] ^ s[24];
+
+    B[0] = s[0] ^ C[4] ^ rotl<1>( C[1] );
+    B[1] = rotl<44>( s[ 6] ^ C[0] ^ rotl<1>( C[2] ) );
+    B[2] = rotl<43>( s[12] ^ C[1] ^ rotl<1>( C[3] ) );
+
+    return B[0] ^ andn( B[1], B[2] ) ^ RC[23];
+  }
+}
+
+namespace Nabiki::Keccak
+{
+  template<size_t N>
+  static auto mineInterleaved( midstate_t const& mid, uint64_t const& target,
+                               uint64_t const& base, uint64_t const& count,
+                               uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    lanes_t<N> a[25], e[25], nonce;
+
+    uint64_t const group_count{ count - count % N };
+    for( uint64_t i{ 0u }; i < group_count; i += N )
+    {
+      for( size_t lane{ 0u }; lane < N; ++lane ) { nonce.v[lane] = base + i + lane; }
+
+      keccakFirst( a, mid, nonce );
+
+      for( uint_fast8_t round{ 1u }; round < 23u; round += 2u )
+      {
+        keccakRound( a, e, RC[round] );
+        keccakRound( e, a, RC[round + 1u] );
+      }
+
+      lanes_t<N> const digest{ keccakLast( a ) };
+      for( size_t lane{ 0u }; lane < N; ++lane )
+      {
+        if( bswap64( digest.v[lane] ) > target || sol_count >= 256u ) { continue; }
+
+        sols[sol_count++] = nonce.v[lane];
+      }
+    }
+
+    if( group_count < count )
+    {
+      mineScalar( mid, target, base + group_count, count - group_count, sols, sol_count );
+    }
+  }
+
+  auto mineBmi2( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    mineInterleaved<LANES>( mid, target, base, count, sols, sol_count );
+  }
+}
+
+#if defined __clang__
+#  pragma clang attribute pop
+#elif defined __GNUC__
+#  pragma GCC pop_options
+#endif // __GNUC__
+
+#endif // __x86_64__
@@ -0,0 +1,635 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpukernel.h"
+#include "midstate.h"
+#include "platforms.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace
+{
+  // what the generated code takes, by pointer, as its only argument
+  struct args_t
+  {
+    uint64_t base;
+    uint64_t count;
+    uint64_t* sols;
+    uint32_t* sol_count;
+  };
+  using routine_t = void (*)( args_t* );
+}
+
+#if defined __x86_64__ || defined _M_X64
+
+using Nabiki::Keccak::RC;
+using Nabiki::Keccak::PI;
+using Nabiki::Keccak::RHO;
+using Nabiki::Keccak::NONCE_ROT;
+
+namespace
+{
+  // x86-64 general purpose registers, by encoding
+  enum reg_t : uint8_t
+  {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8,  R9,  R10, R11, R12, R13, R14, R15
+  };
+
+  // Just enough of an assembler for the routine below: 64-bit integer ops
+  // between registers, immediates and [base + disp32] memory operands.
+  class assembler_t
+  {
+  public:
+    auto size() const -> size_t
+    { return m_code.size(); }
+    auto data() const -> uint8_t const*
+    { return m_code.data(); }
+
+    auto movRR( reg_t const dst, reg_t const src ) -> void
+    { rr( 0x89u, src, dst ); }
+    auto movRI( reg_t const dst, uint64_t const imm ) -> void
+    {
+      if( imm <= 0xFFFFFFFFull )
+      {
+        // a 32-bit move zero-extends, and is half the size
+        if( dst >= R8 ) { byte( 0x41u ); }
+        byte( 0xB8u + (dst & 7u) );
+        imm32( static_cast<uint32_t>(imm) );
+      }
+      else if( fitsImm32( imm ) )
+      {
+        rr( 0xC7u, RAX, dst );
+        imm32( static_cast<uint32_t>(imm) );
+      }
+      else
+      {
+        byte( rex( true, RAX, dst ) );
+        byte( 0xB8u + (dst & 7u) );
+        for( uint_fast8_t i{ 0u }; i < 8u; ++i )
+        {
+          byte( static_cast<uint8_t>(imm >> (i * 8u)) );
+        }
+      }
+    }
+    auto load( reg_t const dst, reg_t const base, int32_t const disp ) -> void
+    { mem( 0x8Bu, dst, base, disp ); }
+    auto store( reg_t const base, int32_t const disp, reg_t const src ) -> void
+    { mem( 0x89u, src, base, disp ); }
+    auto load32( reg_t const dst, reg_t const base, int32_t const disp ) -> void
+    { mem( 0x8Bu, dst, base, disp, false ); }
+    auto store32( reg_t const base, int32_t const disp, reg_t const src ) -> void
+    { mem( 0x89u, src, base, disp, false ); }
+
+    auto xorRR( reg_t const dst, reg_t const src ) -> void
+    { rr( 0x31u, src, dst ); }
+    auto xorRM( reg_t const dst, reg_t const base, int32_t const disp ) -> void
+    { mem( 0x33u, dst, base, disp ); }
+    // immediates that don't sign-extend from 32 bits go through `scratch`
+    auto xorRI( reg_t const dst, uint64_t const imm, reg_t const scratch ) -> void
+    { opRI( 6u, 0x31u, dst, imm, scratch ); }
+    auto andRR( reg_t const dst, reg_t const src ) -> void
+    { rr( 0x21u, src, dst ); }
+    auto andRI( reg_t const dst, uint64_t const imm, reg_t const scratch ) -> void
+    { opRI( 4u, 0x21u, dst, imm, scratch ); }
+    auto addRR( reg_t const dst, reg_t const src ) -> void
+    { rr( 0x01u, src, dst ); }
+    auto addRM( reg_t const dst, reg_t const base, int32_t const disp ) -> void
+    { mem( 0x03u, dst, base, disp ); }
+    auto cmpRR( reg_t const lhs, reg_t const rhs ) -> void
+    { rr( 0x39u, rhs, lhs ); }
+    auto cmpRM( reg_t const lhs, reg_t const base, int32_t const disp ) -> void
+    { mem( 0x3Bu, lhs, base, disp ); }
+    auto cmpRI32( reg_t const lhs, uint32_t const imm ) -> void
+    {
+      rr( 0x81u, static_cast<reg_t>(7u), lhs, false );
+      imm32( imm );
+    }
+    auto notR( reg_t const dst ) -> void
+    { rr( 0xF7u, static_cast<reg_t>(2u), dst ); }
+    auto rolRI( reg_t const dst, uint8_t const count ) -> void
+    {
+      if( count % 64u == 0u ) { return; }
+      rr( 0xC1u, RAX, dst );
+      byte( count % 64u );
+    }
+    auto shlRI( reg_t const dst, uint8_t const count ) -> void
+    {
+      rr( 0xC1u, static_cast<reg_t>(4u), dst );
+      byte( count );
+    }
+    auto bswap( reg_t const dst ) -> void
+    {
+      byte( rex( true, RAX, dst ) );
+      byte( 0x0Fu );
+      byte( 0xC8u + (dst & 7u) );
+    }
+    auto incR32( reg_t const dst ) -> void
+    { rr( 0xFFu, RAX, dst, false ); }
+    auto incM( reg_t const base, int32_t const disp ) -> void
+    { mem( 0xFFu, RAX, base, disp ); }
+    auto addRsp( int32_t const imm ) -> void
+    {
+      rr( 0x81u, RAX, RSP );
+      imm32( static_cast<uint32_t>(imm) );
+    }
+    auto subRsp( int32_t const imm ) -> void
+    {
+      rr( 0x81u, static_cast<reg_t>(5u), RSP );
+      imm32( static_cast<uint32_t>(imm) );
+    }
+    auto push( reg_t const reg ) -> void
+    {
+      if( reg >= R8 ) { byte( 0x41u ); }
+      byte( 0x50u + (reg & 7u) );
+    }
+    auto pop( reg_t const reg ) -> void
+    {
+      if( reg >= R8 ) { byte( 0x41u ); }
+      byte( 0x58u + (reg & 7u) );
+    }
+    auto ret() -> void
+    { byte( 0xC3u ); }
+
+    // jumps are emitted with a rel32 to be filled in by bind()
+    auto jmp() -> size_t
+    {
+      byte( 0xE9u );
+      return rel32();
+    }
+    auto ja() -> size_t
+    {
+      byte( 0x0Fu );
+      byte( 0x87u );
+      return rel32();
+    }
+    auto jae() -> size_t
+    {
+      byte( 0x0Fu );
+      byte( 0x83u );
+      return rel32();
+    }
+    // points the jump whose rel32 is at `fixup` to `target`
+    auto bind( size_t const fixup, size_t const target ) -> void
+    {
+      int32_t const rel{ static_cast<int32_t>(target) - static_cast<int32_t>(fixup + 4u) };
+      std::memcpy( &m_code[fixup], &rel, sizeof( rel ) );
+    }
+
+    static auto fitsImm32( uint64_t const imm ) -> bool
+    { return static_cast<int64_t>(imm) == static_cast<int32_t>(imm); }
+
+  private:
+    auto byte( uint8_t const b ) -> void
+    { m_code.push_back( b ); }
+    auto imm32( uint32_t const imm ) -> void
+    {
+      for( uint_fast8_t i{ 0u }; i < 4u; ++i )
+      {
+        byte( static_cast<uint8_t>(imm >> (i * 8u)) );
+      }
+    }
+    auto rel32() -> size_t
+    {
+      imm32( 0u );
+      return m_code.size() - 4u;
+    }
+    static auto rex( bool const wide, reg_t const reg, reg_t const rm ) -> uint8_t
+    { return static_cast<uint8_t>(0x40u | (wide ? 8u : 0u) | (reg >> 3u) << 2u | (rm >> 3u)); }
+
+    auto rr( uint8_t const op, reg_t const reg, reg_t const rm, bool const wide = true ) -> void
+    {
+      uint8_t const prefix{ rex( wide, reg, rm ) };
+      if( prefix != 0x40u ) { byte( prefix ); }
+      byte( op );
+      byte( static_cast<uint8_t>(0xC0u | (reg & 7u) << 3u | (rm & 7u)) );
+    }
+    // always [base + disp32], which sidesteps the RBP/R13 special case;
+    // RSP and R12 as a base need a SIB byte
+    auto mem( uint8_t const op, reg_t const reg, reg_t const base, int32_t const disp, bool const wide = true ) -> void
+    {
+      uint8_t const prefix{ rex( wide, reg, base ) };
+      if( prefix != 0x40u ) { byte( prefix ); }
+      byte( op );
+      byte( static_cast<uint8_t>(0x80u | (reg & 7u) << 3u | (base & 7u)) );
+      if( (base & 7u) == RSP ) { byte( 0x24u ); }
+      imm32( static_cast<uint32_t>(disp) );
+    }
+    auto opRI( uint8_t const ext, uint8_t const op, reg_t const dst, uint64_t const imm, reg_t const scratch ) -> void
+    {
+      if( fitsImm32( imm ) )
+      {
+        rr( 0x81u, static_cast<reg_t>(ext), dst );
+        imm32( static_cast<uint32_t>(imm) );
+        return;
+      }
+      movRI( scratch, imm );
+      rr( op, scratch, dst );
+    }
+
+    std::vector<uint8_t> m_code;
+  };
+
+  // A lane as the generator sees it: either known outright, in which case
+  // it costs nothing until it meets an unknown one, or held in a register.
+  struct value_t
+  {
+    std::optional<uint64_t> known;
+    reg_t reg;
+  };
+
+  static reg_t constexpr C_REGS[5]{ R8, R9, R10, R11, R12 };
+  static reg_t constexpr D_REGS[5]{ R13, R14, R15, RBX, RBP };
+  static reg_t constexpr B_REGS[5]{ RAX, RCX, RDX, RSI, RDI };
+
+  // stack frame: two copies of the state, then the loop bookkeeping
+  static int32_t constexpr FRAME_A{ 0 };
+  static int32_t constexpr FRAME_E{ 200 };
+  static int32_t constexpr FRAME_NONCE{ 400 };
+  static int32_t constexpr FRAME_END{ 408 };
+  static int32_t constexpr FRAME_ARGS{ 416 };
+  // keeps RSP 16-byte aligned after the pushes below, for tidiness' sake
+  static int32_t constexpr FRAME_SIZE{ 440 };
+
+  // where the argument arrives, and the callee-saved registers the routine
+  // uses, per calling convention
+#if defined _WIN32
+  static reg_t constexpr ARG0{ RCX };
+  static std::array constexpr SAVED{ RBX, RBP, RSI, RDI, R12, R13, R14, R15 };
+#else
+  static reg_t constexpr ARG0{ RDI };
+  static std::array constexpr SAVED{ RBX, RBP, R12, R13, R14, R15 };
+#endif // _WIN32
+
+  class generator_t
+  {
+  public:
+    generator_t( midstate_t const& mid ) : m_mid( mid ) {}
+
+    auto run( uint64_t const& target ) -> assembler_t
+    {
+      liveness();
+
+      for( auto const reg : SAVED ) { m_asm.push( reg ); }
+      m_asm.subRsp( FRAME_SIZE );
+
+      m_asm.store( RSP, FRAME_ARGS, ARG0 );
+      m_asm.load( RAX, ARG0, offsetof( args_t, base ) );
+      m_asm.store( RSP, FRAME_NONCE, RAX );
+      m_asm.addRM( RAX, ARG0, offsetof( args_t, count ) );
+      m_asm.store( RSP, FRAME_END, RAX );
+
+      size_t const top{ m_asm.size() };
+      m_asm.load( RAX, RSP, FRAME_NONCE );
+      m_asm.cmpRM( RAX, RSP, FRAME_END );
+      size_t const to_done{ m_asm.jae() };
+
+      m_known.fill( std::nullopt );
+      emitFirst();
+      for( uint_fast8_t round{ 1u }; round < 24u; ++round )
+      {
+        emitRound( round );
+      }
+
+      // the last round leaves lane 0 in R8
+      m_asm.bswap( R8 );
+      m_asm.movRI( R9, target );
+      m_asm.cmpRR( R8, R9 );
+      size_t const to_next{ m_asm.ja() };
+
+      m_asm.load( RDX, RSP, FRAME_ARGS );
+      m_asm.load( R10, RDX, offsetof( args_t, sol_count ) );
+      m_asm.load32( RAX, R10, 0 );
+      m_asm.cmpRI32( RAX, 256u );
+      size_t const to_full{ m_asm.jae() };
+      m_asm.load( R11, RDX, offsetof( args_t, sols ) );
+      m_asm.movRR( RCX, RAX );
+      m_asm.shlRI( RCX, 3u );
+      m_asm.addRR( R11, RCX );
+      m_asm.load( RCX, RSP, FRAME_NONCE );
+      m_asm.store( R11, 0, RCX );
+      m_asm.incR32( RAX );
+      m_asm.store32( R10, 0, RAX );
+
+      m_asm.bind( to_next, m_asm.size() );
+      m_asm.bind( to_full, m_asm.size() );
+      m_asm.incM( RSP, FRAME_NONCE );
+      m_asm.bind( m_asm.jmp(), top );
+
+      m_asm.bind( to_done, m_asm.size() );
+      m_asm.addRsp( FRAME_SIZE );
+      for( size_t i{ SAVED.size() }; i > 0u; --i ) { m_asm.pop( SAVED[i - 1u] ); }
+      m_asm.ret();
+
+      return std::move( m_asm );
+    }
+
+  private:
+    // Works back from lane 0 of the last round to find which lanes each
+    // round actually has to produce. Theta mixes every column into every
+    // lane, so in practice only the last round sheds any.
+    auto liveness() -> void
+    {
+      m_needed[23] = 1u;
+      for( uint_fast8_t round{ 23u }; round > 0u; --round )
+      {
+        uint32_t const out{ m_needed[round] };
+        uint32_t in{ 0u };
+        uint8_t columns{ 0u };
+        for( uint_fast8_t lane{ 0u }; lane < 25u; ++lane )
+        {
+          if( !(out & 1u << lane) ) { continue; }
+          for( uint_fast8_t k{ 0u }; k < 3u; ++k )
+          {
+            uint_fast8_t const b{ static_cast<uint_fast8_t>(lane / 5u * 5u + (lane + k) % 5u) };
+            in |= 1u << PI[b];
+            // D[x] needs the columns either side of it
+            columns |= static_cast<uint8_t>(1u << (PI[b] + 4u) % 5u | 1u << (PI[b] + 1u) % 5u);
+          }
+        }
+        for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+        {
+          if( columns & 1u << x ) { in |= 0x108421u << x; }
+        }
+        m_needed[round - 1u] = in;
+      }
+    }
+
+    auto src() const -> int32_t
+    { return m_flip ? FRAME_E : FRAME_A; }
+    auto dst() const -> int32_t
+    { return m_flip ? FRAME_A : FRAME_E; }
+
+    // dst = b0 ^ (~b1 & b2), with R8 as the working register and R9 as
+    // scratch for wide immediates
+    auto chi( value_t const& b0, value_t const& b1, value_t const& b2, uint64_t const rc ) -> value_t
+    {
+      if( b0.known && b1.known && b2.known )
+      {
+        return { *b0.known ^ (~*b1.known & *b2.known) ^ rc, R8 };
+      }
+
+      if( b1.known && b2.known )
+      {
+        m_asm.movRR( R8, b0.reg );
+        m_asm.xorRI( R8, (~*b1.known & *b2.known) ^ rc, R9 );
+        return { std::nullopt, R8 };
+      }
+      if( b1.known )
+      {
+        m_asm.movRR( R8, b2.reg );
+        m_asm.andRI( R8, ~*b1.known, R9 );
+      }
+      else
+      {
+        m_asm.movRR( R8, b1.reg );
+        m_asm.notR( R8 );
+        if( b2.known ) { m_asm.andRI( R8, *b2.known, R9 ); }
+        else { m_asm.andRR( R8, b2.reg ); }
+      }
+      if( b0.known )
+      {
+        m_asm.xorRI( R8, *b0.known ^ rc, R9 );
+      }
+      else
+      {
+        m_asm.xorRR( R8, b0.reg );
+        if( rc != 0u ) { m_asm.xorRI( R8, rc, R9 ); }
+      }
+      return { std::nullopt, R8 };
+    }
+
+    // chi over one row of B, keeping whichever outputs are still needed
+    auto emitChi( uint_fast8_t const round, uint_fast8_t const row, value_t const (&B)[5] ) -> void
+    {
+      for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+      {
+        uint_fast8_t const lane{ static_cast<uint_fast8_t>(row * 5u + x) };
+        if( !(m_needed[round] & 1u << lane) ) { continue; }
+
+        value_t const out{ chi( B[x], B[(x + 1u) % 5u], B[(x + 2u) % 5u], lane == 0u ? RC[round] : 0u ) };
+        if( round == 23u )
+        {
+          // only lane 0 gets here, and it stays in R8
+          if( out.known ) { m_asm.movRI( R8, *out.known ); }
+          continue;
+        }
+        m_known_next[lane] = out.known;
+        if( !out.known ) { m_asm.store( RSP, dst() + lane * 8, R8 ); }
+      }
+    }
+
+    // round 0 picks up from the midstate, which is already past rho and
+    // pi; only the nonce lanes aren't known
+    auto emitFirst() -> void
+    {
+      m_known_next.fill( std::nullopt );
+      m_asm.load( R8, RSP, FRAME_NONCE );
+
+      for( uint_fast8_t row{ 0u }; row < 5u; ++row )
+      {
+        value_t B[5];
+        for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+        {
+          uint_fast8_t const lane{ static_cast<uint_fast8_t>(row * 5u + x) };
+          B[x].reg = B_REGS[x];
+          if( NONCE_ROT[lane] < 0 )
+          {
+            B[x].known = m_mid[lane];
+            continue;
+          }
+          m_asm.movRR( B_REGS[x], R8 );
+          m_asm.rolRI( B_REGS[x], static_cast<uint8_t>(NONCE_ROT[lane]) );
+          m_asm.xorRI( B_REGS[x], m_mid[lane], R9 );
+        }
+        // chi clobbers R8, so put the nonce back for the next row
+        emitChi( 0u, row, B );
+        m_asm.load( R8, RSP, FRAME_NONCE );
+      }
+
+      m_known = m_known_next;
+      m_flip = !m_flip;
+    }
+
+    auto emitRound( uint_fast8_t const round ) -> void
+    {
+      // which B, D and C values the needed outputs draw on
+      uint32_t b_needed{ 0u };
+      uint8_t d_needed{ 0u }, c_needed{ 0u };
+      for( uint_fast8_t lane{ 0u }; lane < 25u; ++lane )
+      {
+        if( !(m_needed[round] & 1u << lane) ) { continue; }
+        for( uint_fast8_t k{ 0u }; k < 3u; ++k )
+        {
+          uint_fast8_t const b{ static_cast<uint_fast8_t>(lane / 5u * 5u + (lane + k) % 5u) };
+          b_needed |= 1u << b;
+          d_needed |= static_cast<uint8_t>(1u << PI[b] % 5u);
+        }
+      }
+      for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+      {
+        if( d_needed & 1u << x ) { c_needed |= static_cast<uint8_t>(1u << (x + 4u) % 5u | 1u << (x + 1u) % 5u); }
+      }
+
+      // theta, with RAX as scratch since no B is live yet
+      value_t C[5], D[5];
+      for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+      {
+        C[x].reg = C_REGS[x];
+        if( !(c_needed & 1u << x) ) { continue; }
+
+        uint64_t known{ 0u };
+        bool loaded{ false };
+        for( uint_fast8_t y{ 0u }; y < 5u; ++y )
+        {
+          uint_fast8_t const lane{ static_cast<uint_fast8_t>(y * 5u + x) };
+          if( m_known[lane] ) { known ^= *m_known[lane]; }
+          else if( !loaded ) { m_asm.load( C_REGS[x], RSP, src() + lane * 8 ); loaded = true; }
+          else { m_asm.xorRM( C_REGS[x], RSP, src() + lane * 8 ); }
+        }
+        if( !loaded ) { C[x].known = known; }
+        else if( known != 0u ) { m_asm.xorRI( C_REGS[x], known, RAX ); }
+      }
+      for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+      {
+        D[x].reg = D_REGS[x];
+        if( !(d_needed & 1u << x) ) { continue; }
+
+        value_t const& left{ C[(x + 4u) % 5u] };
+        value_t const& right{ C[(x + 1u) % 5u] };
+        if( left.known && right.known )
+        {
+          D[x].known = *left.known ^ rotl64( *right.known, 1 );
+        }
+        else if( right.known )
+        {
+          m_asm.movRR( D_REGS[x], left.reg );
+          m_asm.xorRI( D_REGS[x], rotl64( *right.known, 1 ), RAX );
+        }
+        else
+        {
+          m_asm.movRR( D_REGS[x], right.reg );
+          m_asm.rolRI( D_REGS[x], 1u );
+          if( left.known ) { m_asm.xorRI( D_REGS[x], *left.known, RAX ); }
+          else { m_asm.xorRR( D_REGS[x], left.reg ); }
+        }
+      }
+
+      // rho, pi and chi a row at a time; the C registers are free now
+      m_known_next.fill( std::nullopt );
+      for( uint_fast8_t row{ 0u }; row < 5u; ++row )
+      {
+        value_t B[5];
+        for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+        {
+          uint_fast8_t const b{ static_cast<uint_fast8_t>(row * 5u + x) };
+          uint_fast8_t const lane{ PI[b] };
+          value_t const& d{ D[lane % 5u] };
+          B[x].reg = B_REGS[x];
+          if( !(b_needed & 1u << b) ) { continue; }
+
+          if( m_known[lane] && d.known )
+          {
+            B[x].known = rotl64( *m_known[lane] ^ *d.known, RHO[b] );
+            continue;
+          }
+          if( m_known[lane] )
+          {
+            m_asm.movRR( B_REGS[x], d.reg );
+            m_asm.xorRI( B_REGS[x], *m_known[lane], R9 );
+          }
+          else
+          {
+            m_asm.load( B_REGS[x], RSP, src() + lane * 8 );
+            if( d.known ) { m_asm.xorRI( B_REGS[x], *d.known, R9 ); }
+            else { m_asm.xorRR( B_REGS[x], d.reg ); }
+          }
+          m_asm.rolRI( B_REGS[x], RHO[b] );
+        }
+        emitChi( round, row, B );
+      }
+
+      m_known = m_known_next;
+      m_flip = !m_flip;
+    }
+
+    midstate_t const& m_mid;
+    assembler_t m_asm;
+    // lanes that must be produced by each round
+    std::array<uint32_t, 24u> m_needed{};
+    // lanes of the current and next state whose value is known here
+    std::array<std::optional<uint64_t>, 25u> m_known{};
+    std::array<std::optional<uint64_t>, 25u> m_known_next{};
+    bool m_flip{ false };
+  };
+}
+
+#endif // __x86_64__
+
+namespace Nabiki::Keccak
+{
+  jit_kernel_t::jit_kernel_t( void* code, size_t const& size ) :
+    m_code( code ),
+    m_size( size )
+  {}
+
+  jit_kernel_t::~jit_kernel_t()
+  {
+    FreeExecutable( m_code, m_size );
+  }
+
+  auto jit_kernel_t::mine( uint64_t const& base, uint64_t const& count,
+                           uint64_t* sols, uint32_t& sol_count ) const -> void
+  {
+    args_t args{ base, count, sols, &sol_count };
+    reinterpret_cast<routine_t>(m_code)( &args );
+  }
+
+  auto buildJitKernel( [[maybe_unused]] midstate_t const& mid,
+                       [[maybe_unused]] uint64_t const& target ) -> std::shared_ptr<jit_kernel_t const>
+  {
+#if defined __x86_64__ || defined _M_X64
+    assembler_t const code{ generator_t{ mid }.run( target ) };
+
+    void* const mem{ AllocExecutable( code.size() ) };
+    if( !mem ) { return nullptr; }
+
+    std::memcpy( mem, code.data(), code.size() );
+    if( !ProtectExecutable( mem, code.size() ) )
+    {
+      FreeExecutable( mem, code.size() );
+      return nullptr;
+    }
+
+    return std::shared_ptr<jit_kernel_t const>( new jit_kernel_t( mem, code.size() ) );
+#else
+    return nullptr;
+#endif // __x86_64__
+  }
+}
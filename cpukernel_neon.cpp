@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined __aarch64__
+
+#include "cpukernel_neon.h"
+
+#include <cstdint>
+#include <arm_neon.h>
+
+namespace
+{
+  // baseline AArch64: no 64-bit vector rotate either, but a shift left and
+  // a shift-right-and-insert into the result do the same in two
+  struct neon_ops_t
+  {
+    template<int R>
+    static auto inline rotl( uint64x2_t const x ) -> uint64x2_t
+    {
+      return vsriq_n_u64( vshlq_n_u64( x, R ), x, 64 - R );
+    }
+
+    static auto inline xor3( uint64x2_t const a, uint64x2_t const b, uint64x2_t const c ) -> uint64x2_t
+    {
+      return veorq_u64( veorq_u64( a, b ), c );
+    }
+
+    static auto inline rax1( uint64x2_t const a, uint64x2_t const b ) -> uint64x2_t
+    {
+      return veorq_u64( a, rotl<1>( b ) );
+    }
+
+    template<int R>
+    static auto inline xar( uint64x2_t const a, uint64x2_t const b ) -> uint64x2_t
+    {
+      return rotl<R>( veorq_u64( a, b ) );
+    }
+
+    // vbicq_u64( b, c ) is b & ~c
+    static auto inline bcax( uint64x2_t const a, uint64x2_t const b, uint64x2_t const c ) -> uint64x2_t
+    {
+      return veorq_u64( a, vbicq_u64( b, c ) );
+    }
+  };
+}
+
+namespace Nabiki::Keccak
+{
+  auto mineNeon( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    Neon::mine<neon_ops_t>( mid, target, base, count, sols, sol_count );
+  }
+}
+
+#endif // __aarch64__
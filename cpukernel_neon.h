@@ -0,0 +1,227 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _CPUKERNEL_NEON_H_
+#define _CPUKERNEL_NEON_H_
+
+#include "cpukernel.h"
+#include "platforms.h"
+
+#include <cstdint>
+#include <arm_neon.h>
+
+// Keccak over two nonces at a time, one per lane of a uint64x2_t, shared by
+// the NEON and SHA3 kernels. It's written in terms of the four operations
+// the SHA3 extension added for exactly this job; `Ops` supplies them, either
+// as the real instructions or as the plain NEON sequences they replace:
+//
+//   xor3( a, b, c )    a ^ b ^ c            (EOR3)
+//   rax1( a, b )       a ^ rotl( b, 1 )     (RAX1)
+//   xar<R>( a, b )     rotl( a ^ b, R )     (XAR)
+//   bcax( a, b, c )    a ^ (b & ~c)         (BCAX)
+//   rotl<R>( a )
+//
+// Each including file builds the templates for its own `Ops`, under its own
+// target options, so nothing here may be instantiated from anywhere else.
+namespace Nabiki::Keccak::Neon
+{
+  template<typename Ops>
+  static auto inline xor5( uint64x2_t const a, uint64x2_t const b, uint64x2_t const c,
+                           uint64x2_t const d, uint64x2_t const e ) -> uint64x2_t
+  {
+    return Ops::xor3( Ops::xor3( a, b, c ), d, e );
+  }
+
+  template<typename Ops>
+  static auto inline chi( uint64x2_t (&s)[25], uint_fast8_t const offset, uint64x2_t const (&b)[5] ) -> void
+  {
+    s[offset     ] = Ops::bcax( b[0], b[2], b[1] );
+    s[offset + 1u] = Ops::bcax( b[1], b[3], b[2] );
+    s[offset + 2u] = Ops::bcax( b[2], b[4], b[3] );
+    s[offset + 3u] = Ops::bcax( b[3], b[0], b[4] );
+    s[offset + 4u] = Ops::bcax( b[4], b[1], b[0] );
+  }
+
+  // one full round, reading the state from `a` and writing it to `e`; rho,
+  // pi and chi are fused so that only one row of B is ever live
+  template<typename Ops>
+  static auto inline keccakRound( uint64x2_t const (&a)[25], uint64x2_t (&e)[25], uint64_t const rc ) -> void
+  {
+    uint64x2_t C[5], D[5], B[5];
+
+    C[0] = xor5<Ops>( a[0], a[5], a[10], a[15], a[20] );
+    C[1] = xor5<Ops>( a[1], a[6], a[11], a[16], a[21] );
+    C[2] = xor5<Ops>( a[2], a[7], a[12], a[17], a[22] );
+    C[3] = xor5<Ops>( a[3], a[8], a[13], a[18], a[23] );
+    C[4] = xor5<Ops>( a[4], a[9], a[14], a[19], a[24] );
+
+    D[0] = Ops::rax1( C[4], C[1] );
+    D[1] = Ops::rax1( C[0], C[2] );
+    D[2] = Ops::rax1( C[1], C[3] );
+    D[3] = Ops::rax1( C[2], C[4] );
+    D[4] = Ops::rax1( C[3], C[0] );
+
+    B[0] = veorq_u64( a[ 0], D[0] );
+    B[1] = Ops::template xar<44>( a[ 6], D[1] );
+    B[2] = Ops::template xar<43>( a[12], D[2] );
+    B[3] = Ops::template xar<21>( a[18], D[3] );
+    B[4] = Ops::template xar<14>( a[24], D[4] );
+    chi<Ops>( e, 0u, B );
+    e[0] = veorq_u64( e[0], vdupq_n_u64( rc ) );
+
+    B[0] = Ops::template xar<28>( a[ 3], D[3] );
+    B[1] = Ops::template xar<20>( a[ 9], D[4] );
+    B[2] = Ops::template xar<3>( a[10], D[0] );
+    B[3] = Ops::template xar<45>( a[16], D[1] );
+    B[4] = Ops::template xar<61>( a[22], D[2] );
+    chi<Ops>( e, 5u, B );
+
+    B[0] = Ops::template xar<1>( a[ 1], D[1] );
+    B[1] = Ops::template xar<6>( a[ 7], D[2] );
+    B[2] = Ops::template xar<25>( a[13], D[3] );
+    B[3] = Ops::template xar<8>( a[19], D[4] );
+    B[4] = Ops::template xar<18>( a[20], D[0] );
+    chi<Ops>( e, 10u, B );
+
+    B[0] = Ops::template xar<27>( a[ 4], D[4] );
+    B[1] = Ops::template xar<36>( a[ 5], D[0] );
+    B[2] = Ops::template xar<10>( a[11], D[1] );
+    B[3] = Ops::template xar<15>( a[17], D[2] );
+    B[4] = Ops::template xar<56>( a[23], D[3] );
+    chi<Ops>( e, 15u, B );
+
+    B[0] = Ops::template xar<62>( a[ 2], D[2] );
+    B[1] = Ops::template xar<55>( a[ 8], D[3] );
+    B[2] = Ops::template xar<39>( a[14], D[4] );
+    B[3] = Ops::template xar<41>( a[15], D[0] );
+    B[4] = Ops::template xar<2>( a[21], D[1] );
+    chi<Ops>( e, 20u, B );
+  }
+
+  // the midstate is round 0 up to (but not including) chi, computed with a
+  // zeroed nonce lane; theta spreads the nonce into eleven lanes, each of
+  // which only needs the matching rotation XORed back in
+  template<typename Ops>
+  static auto inline keccakFirst( uint64x2_t (&s)[25], midstate_t const& mid, uint64x2_t const nonce ) -> void
+  {
+    uint64x2_t B[5];
+
+    B[0] = vdupq_n_u64( mid[ 0] );
+    B[1] = vdupq_n_u64( mid[ 1] );
+    B[2] = veorq_u64( vdupq_n_u64( mid[ 2] ), Ops::template rotl<44>( nonce ) );
+    B[3] = vdupq_n_u64( mid[ 3] );
+    B[4] = veorq_u64( vdupq_n_u64( mid[ 4] ), Ops::template rotl<14>( nonce ) );
+    chi<Ops>( s, 0u, B );
+    s[0] = veorq_u64( s[0], vdupq_n_u64( RC[0] ) );
+    s[ 4] = veorq_u64( vdupq_n_u64( mid[25] ), Ops::template rotl<14>( nonce ) );
+
+    B[0] = vdupq_n_u64( mid[ 5] );
+    B[1] = veorq_u64( vdupq_n_u64( mid[ 6] ), Ops::template rotl<20>( nonce ) );
+    B[2] = vdupq_n_u64( mid[ 7] );
+    B[3] = vdupq_n_u64( mid[ 8] );
+    B[4] = veorq_u64( vdupq_n_u64( mid[ 9] ), Ops::template rotl<62>( nonce ) );
+    chi<Ops>( s, 5u, B );
+    s[ 6] = veorq_u64( vdupq_n_u64( mid[26] ), Ops::template rotl<20>( nonce ) );
+
+    B[0] = vdupq_n_u64( mid[10] );
+    B[1] = veorq_u64( vdupq_n_u64( mid[11] ), Ops::template rotl<7>( nonce ) );
+    B[2] = vdupq_n_u64( mid[12] );
+    B[3] = veorq_u64( vdupq_n_u64( mid[13] ), Ops::template rotl<8>( nonce ) );
+    B[4] = vdupq_n_u64( mid[14] );
+    chi<Ops>( s, 10u, B );
+    s[13] = veorq_u64( vdupq_n_u64( mid[27] ), Ops::template rotl<8>( nonce ) );
+
+    B[0] = veorq_u64( vdupq_n_u64( mid[15] ), Ops::template rotl<27>( nonce ) );
+    B[1] = vdupq_n_u64( mid[16] );
+    B[2] = vdupq_n_u64( mid[17] );
+    B[3] = veorq_u64( vdupq_n_u64( mid[18] ), Ops::template rotl<16>( nonce ) );
+    B[4] = vdupq_n_u64( mid[19] );
+    chi<Ops>( s, 15u, B );
+    s[15] = veorq_u64( vdupq_n_u64( mid[28] ), Ops::template rotl<27>( nonce ) );
+
+    B[0] = veorq_u64( vdupq_n_u64( mid[20] ), Ops::template rotl<63>( nonce ) );
+    B[1] = veorq_u64( vdupq_n_u64( mid[21] ), Ops::template rotl<55>( nonce ) );
+    B[2] = veorq_u64( vdupq_n_u64( mid[22] ), Ops::template rotl<39>( nonce ) );
+    B[3] = vdupq_n_u64( mid[23] );
+    B[4] = vdupq_n_u64( mid[24] );
+    chi<Ops>( s, 20u, B );
+    s[22] = veorq_u64( vdupq_n_u64( mid[29] ), Ops::template rotl<39>( nonce ) );
+  }
+
+  // round 23 only has to produce lane 0, which depends on three lanes
+  template<typename Ops>
+  static auto inline keccakLast( uint64x2_t const (&s)[25] ) -> uint64x2_t
+  {
+    uint64x2_t C[5], B[3];
+
+    C[0] = xor5<Ops>( s[0], s[5], s[10], s[15], s[20] );
+    C[1] = xor5<Ops>( s[1], s[6], s[11], s[16], s[21] );
+    C[2] = xor5<Ops>( s[2], s[7], s[12], s[17], s[22] );
+    C[3] = xor5<Ops>( s[3], s[8], s[13], s[18], s[23] );
+    C[4] = xor5<Ops>( s[4], s[9], s[14], s[19], s[24] );
+
+    B[0] = veorq_u64( s[ 0], Ops::rax1( C[4], C[1] ) );
+    B[1] = Ops::template xar<44>( s[ 6], Ops::rax1( C[0], C[2] ) );
+    B[2] = Ops::template xar<43>( s[12], Ops::rax1( C[1], C[3] ) );
+
+    return veorq_u64( Ops::bcax( B[0], B[2], B[1] ), vdupq_n_u64( RC[23] ) );
+  }
+
+  template<typename Ops>
+  static auto mine( midstate_t const& mid, uint64_t const& target,
+                    uint64_t const& base, uint64_t const& count,
+                    uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    uint64x2_t a[25], e[25];
+
+    uint64_t const vec_count{ count & ~1ull };
+    for( uint64_t i{ 0u }; i < vec_count; i += 2u )
+    {
+      uint64_t const nonces[2]{ base + i, base + i + 1u };
+
+      keccakFirst<Ops>( a, mid, vld1q_u64( nonces ) );
+
+      for( uint_fast8_t round{ 1u }; round < 23u; round += 2u )
+      {
+        keccakRound<Ops>( a, e, RC[round] );
+        keccakRound<Ops>( e, a, RC[round + 1u] );
+      }
+
+      uint64x2_t const digest{ keccakLast<Ops>( a ) };
+      uint64_t const lanes[2]{ vgetq_lane_u64( digest, 0 ), vgetq_lane_u64( digest, 1 ) };
+      for( uint_fast8_t lane{ 0u }; lane < 2u; ++lane )
+      {
+        if( bswap64( lanes[lane] ) > target || sol_count >= 256u ) { continue; }
+
+        sols[sol_count++] = nonces[lane];
+      }
+    }
+
+    if( vec_count < count )
+    {
+      mineScalar( mid, target, base + vec_count, count - vec_count, sols, sol_count );
+    }
+  }
+}
+
+#endif // !_CPUKERNEL_NEON_H_
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpukernel.h"
+#include "keccak_kernel.h"
+
+#include <cstdint>
+
+namespace Nabiki::Keccak
+{
+  auto minePortable( midstate_t const& mid, uint64_t const& target,
+                     uint64_t const& base, uint64_t const& count,
+                     uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    for( uint64_t nonce{ base }; nonce < base + count; ++nonce )
+    {
+      if( keccak_mine( mid.data(), nonce ) > target || sol_count >= 256u ) { continue; }
+
+      sols[sol_count++] = nonce;
+    }
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined __aarch64__
+
+// everything with outside linkage comes in ahead of the target options, so
+// none of it can be built with instructions the CPU might not have
+#include "cpukernel.h"
+#include "platforms.h"
+
+#include <cstdint>
+#include <arm_neon.h>
+
+// this whole file is built for ARMv8.2-A with the SHA3 extension regardless
+// of the baseline target; selectKernel() only hands the kernel out on CPUs
+// that report it. It has to stay apart from cpukernel_neon.cpp, or the
+// compiler is free to use these instructions in the baseline kernel too.
+#if defined __clang__
+#  pragma clang attribute push( __attribute__((target("sha3"))), apply_to = function )
+#elif defined __GNUC__
+#  pragma GCC push_options
+#  pragma GCC target( "arch=armv8.2-a+sha3" )
+#endif // __GNUC__
+
+#include "cpukernel_neon.h"
+
+namespace
+{
+  struct sha3_ops_t
+  {
+    // XAR rotates right, and by at least one
+    template<int R>
+    static auto inline rotl( uint64x2_t const x ) -> uint64x2_t
+    {
+      return vxarq_u64( x, vdupq_n_u64( 0u ), 64 - R );
+    }
+
+    static auto inline xor3( uint64x2_t const a, uint64x2_t const b, uint64x2_t const c ) -> uint64x2_t
+    {
+      return veor3q_u64( a, b, c );
+    }
+
+    static auto inline rax1( uint64x2_t const a, uint64x2_t const b ) -> uint64x2_t
+    {
+      return vrax1q_u64( a, b );
+    }
+
+    template<int R>
+    static auto inline xar( uint64x2_t const a, uint64x2_t const b ) -> uint64x2_t
+    {
+      return vxarq_u64( a, b, 64 - R );
+    }
+
+    static auto inline bcax( uint64x2_t const a, uint64x2_t const b, uint64x2_t const c ) -> uint64x2_t
+    {
+      return vbcaxq_u64( a, b, c );
+    }
+  };
+}
+
+namespace Nabiki::Keccak
+{
+  auto mineSha3( midstate_t const& mid, uint64_t const& target,
+                 uint64_t const& base, uint64_t const& count,
+                 uint64_t* sols, uint32_t& sol_count ) -> void
+  {
+    Neon::mine<sha3_ops_t>( mid, target, base, count, sols, sol_count );
+  }
+}
+
+#if defined __clang__
+#  pragma clang attribute pop
+#elif defined __GNUC__
+#  pragma GCC pop_options
+#endif // __GNUC__
+
+#endif // __aarch64__
@@ -23,99 +23,365 @@
 
 #include "cpusolver.h"
 #include "devicetelemetry.h"
+#include "cpukernel.h"
+#include "platforms.h"
+#include "log.h"
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
+#include <vector>
+#include <string>
+#include <string_view>
 
 using namespace std::chrono;
-
-// --------------------------------------------------------------------
+using namespace std::literals;
 
 namespace
 {
-  static auto bswap64( uint64_t const& in )
-  {
-    uint64_t out{ 0 };
-    uint8_t* temp = reinterpret_cast<uint8_t*>(&out);
-    uint8_t const* t_in = reinterpret_cast<uint8_t const*>(&in);
-
-    temp[0] = t_in[7];
-    temp[1] = t_in[6];
-    temp[2] = t_in[5];
-    temp[3] = t_in[4];
-    temp[4] = t_in[3];
-    temp[5] = t_in[2];
-    temp[6] = t_in[1];
-    temp[7] = t_in[0];
-
-    return out;
-  }
+  // nonces hashed between checks for new work or a stop request, and the
+  // unit ranges are split in; a multiple of every kernel's width
+  static uint64_t constexpr STEP_SIZE{ 1ull << 12 };
 }
 
-CPUSolver::CPUSolver( double const& intensity ) noexcept :
+CPUSolver::CPUSolver( double const& intensity, std::vector<int32_t> const& cpus ) noexcept :
   m_telemetry_handle( Nabiki::MakeDeviceTelemetryObject( nullptr ) ),
+  m_kernel( Nabiki::Keccak::selectKernel( MinerState::getCpuKernel() ) ),
+  // a throwaway build finds out whether generated code can run at all
+  m_use_jit( MinerState::getCpuJit() && Nabiki::Keccak::buildJitKernel( midstate_t{}, 0u ) ),
+  m_name( m_telemetry_handle->getName() + " ("s + std::string( m_use_jit ? "jit"sv : m_kernel.name ) +
+          " x"s + std::to_string( cpus.size() ) + ")"s ),
   m_stop( false ),
-  m_new_target( true ),
-  m_new_message( true ),
-  m_device_initialized( false ),
-  temp_time( 0 ),
-  temp_average( 0 ),
-  m_hash_count( 0 ),
-  m_hash_count_samples( 0 ),
-  m_hash_average( 0 ),
-  m_target( 0 ),
-  m_message{},
-  h_solution_count( 0 ),
-  h_solutions{},
+  m_epoch( 0u ),
   m_intensity( intensity <= 41.99 ? intensity : 41.99 ),
-  m_threads( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity )) )
+  m_lease_size( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity )) ),
+  m_job_gen( 0u ),
+  m_switch_start( 0. ),
+  m_switch_epoch( 0u ),
+  m_switch_time( 0. ),
+  m_active( 0u ),
+  m_samples{},
+  m_sample_head( 0u ),
+  m_sample_count( 0u )
 {
-  sph_keccak256_init( &m_ctx );
+  if( MinerState::getCpuJit() && !m_use_jit )
+  {
+    Log::pushLog( "Unable to generate CPU mining code; using the \""s + std::string( m_kernel.name ) +
+                  "\" kernel instead."s );
+  }
+
+  // leases are walked in whole steps
+  m_lease_size = (m_lease_size + STEP_SIZE - 1u) / STEP_SIZE * STEP_SIZE;
+
+  for( auto const& cpu : cpus )
+  {
+    auto& worker{ m_workers.emplace_back( std::make_unique<worker_t>() ) };
+    worker->cpu = cpu;
+    worker->stop = false;
+    worker->hashes = 0u;
+    worker->epoch = 0u;
+    worker->next = worker->end = 0u;
+  }
 }
 
 CPUSolver::~CPUSolver()
 {
-  if( m_run_thread.joinable() )
-    m_run_thread.join();
+  stopFinding();
 }
 
 auto CPUSolver::findSolution() -> void
 {
-  uint64_t solution;
-  message_t in_buffer;
-  hash_t out_buffer;
+  runWorker( *m_workers.front() );
+}
+
+auto CPUSolver::startFinding() -> void
+{
+  updateTarget();
+  setThreadCount( static_cast<uint32_t>( m_workers.size() ) );
+  m_sampler = std::thread( &CPUSolver::runSampler, this );
+}
+
+auto CPUSolver::stopFinding() -> void
+{
+  {
+    guard lock{ m_sample_mutex };
+    m_stop = true;
+  }
+  m_sample_cv.notify_all();
+  if( m_sampler.joinable() )
+    m_sampler.join();
+
+  setThreadCount( 0u );
+}
+
+auto CPUSolver::updateTarget() -> void
+{
+  loadJob();
+}
+
+auto CPUSolver::updateMessage() -> void
+{
+  m_switch_start.store( duration<double, std::milli>( steady_clock::now().time_since_epoch() ).count(),
+                        std::memory_order_release );
+
+  // the new job is published first, so no worker on the new epoch can
+  // still be hashing the old message
+  loadJob();
+  m_epoch.fetch_add( 1u, std::memory_order_acq_rel );
+}
+
+auto CPUSolver::loadJob() -> void
+{
+  guard lock{ m_job_mutex };
+  m_job = MinerState::getJob();
+  m_jit = m_use_jit ? Nabiki::Keccak::buildJitKernel( m_job->midstate, m_job->target_num ) : nullptr;
+  m_job_gen.fetch_add( 1u, std::memory_order_release );
+}
+
+auto CPUSolver::setThreadCount( uint32_t const& count ) -> void
+{
+  guard lock{ m_pool_mutex };
+
+  uint32_t const target{ m_stop ? 0u : std::min( count, static_cast<uint32_t>( m_workers.size() ) ) };
+
+  // anything left in a retired worker's range is picked up by stealing
+  for( uint32_t i{ target }; i < m_active; ++i )
+  {
+    m_workers[i]->stop = true;
+  }
+  for( uint32_t i{ target }; i < m_active; ++i )
+  {
+    if( m_workers[i]->thread.joinable() )
+      m_workers[i]->thread.join();
+  }
+
+  for( uint32_t i{ m_active }; i < target; ++i )
+  {
+    m_workers[i]->stop = false;
+    m_workers[i]->thread = std::thread( &CPUSolver::runWorker, this, std::ref( *m_workers[i] ) );
+  }
+
+  m_active = target;
+}
+
+auto CPUSolver::getHashrate( seconds const& window ) -> double const
+{
+  guard lock{ m_sample_mutex };
+
+  // one sample per second, so the window is a sample count; shorter
+  // histories just average over what there is
+  size_t const span{ std::min( static_cast<size_t>( window.count() ), m_sample_count - 1u ) };
+  if( m_sample_count < 2u || span == 0u ) { return 0; }
+
+  uint64_t const newest{ m_samples[(m_sample_head + m_samples.size() - 1u) % m_samples.size()] };
+  uint64_t const oldest{ m_samples[(m_sample_head + m_samples.size() - 1u - span) % m_samples.size()] };
+
+  return static_cast<double>( newest - oldest ) / span / 1000000.0;
+}
+
+auto CPUSolver::getHashCount() -> uint64_t const
+{
+  uint64_t hashes{ 0u };
+  for( auto const& worker : m_workers )
+  {
+    hashes += worker->hashes.load( std::memory_order_relaxed );
+  }
+  return hashes;
+}
+
+auto CPUSolver::getLaunchTime() -> double const
+{
+  // every worker hashes STEP_SIZE nonces per kernel call, all at once
+  double const hashrate{ getHashrate() };
+  return hashrate > 0 ? STEP_SIZE * m_active / (hashrate * 1000.0) : 0;
+}
+
+auto CPUSolver::noteSwitch( uint64_t const& epoch ) -> void
+{
+  double const took{ duration<double, std::milli>( steady_clock::now().time_since_epoch() ).count() -
+                     m_switch_start.load( std::memory_order_acquire ) };
+
+  if( m_switch_epoch.exchange( epoch, std::memory_order_acq_rel ) != epoch )
+  {
+    m_switch_time.store( took, std::memory_order_release );
+    return;
+  }
+
+  double seen{ m_switch_time.load( std::memory_order_acquire ) };
+  while( took > seen && !m_switch_time.compare_exchange_weak( seen, took, std::memory_order_acq_rel ) ) {}
+}
+
+auto CPUSolver::runSampler() -> void
+{
+  std::unique_lock<std::mutex> lock{ m_sample_mutex };
+  auto next{ steady_clock::now() };
+  uint64_t ticks{ 0u };
 
   do
   {
-    if( m_new_target )
+    uint64_t hashes{ 0u };
+    for( auto const& worker : m_workers )
     {
-      m_target = MinerState::getTargetNum();
-      m_new_target = false;
+      hashes += worker->hashes.load( std::memory_order_relaxed );
     }
-    if( m_new_message )
+
+    m_samples[m_sample_head] = hashes;
+    m_sample_head = (m_sample_head + 1u) % m_samples.size();
+    m_sample_count = std::min( m_sample_count + 1u, m_samples.size() );
+
+    // give each load sample a few seconds to settle
+    if( MinerState::getCpuIdle() && ++ticks % 5u == 0u )
     {
-      m_message = MinerState::getMessage();
-      m_new_message = false;
+      lock.unlock();
+      throttle();
+      lock.lock();
     }
 
-    solution = MinerState::getIncSearchSpace( 1 );
-    std::memcpy( in_buffer.data(), m_message.data(), 84 );
-    std::memcpy( &in_buffer[64], &solution, 8 );
+    next += 1s;
+  }
+  while( !m_sample_cv.wait_until( lock, next, [&]{ return m_stop.load(); } ) );
+}
+
+auto CPUSolver::throttle() -> void
+{
+  uint32_t const active{ m_active };
+  uint32_t const cpus{ std::max( std::thread::hardware_concurrency(), 1u ) };
+
+  // our own workers show up in the load too; the rest belongs to
+  // everything else, and we only ever take what it leaves. The load is
+  // measured since the last call, and only this changes m_active while
+  // idling, so the same workers were running for the whole window
+  double const load{ GetSystemLoad() };
+  double const others{ load < 0 ? 0 : std::max( load - active, 0.0 ) };
+  uint32_t const room{ others >= cpus ? 0u : static_cast<uint32_t>( cpus - std::ceil( others ) ) };
 
-    sph_keccak256( &m_ctx, in_buffer.data(), in_buffer.size() );
-    sph_keccak256_close( &m_ctx, out_buffer.data() );
+  // back off hard when something is kept waiting, and creep back one
+  // thread at a time
+  uint32_t target{ active };
+  if( GetCpuPressure() >= MinerState::getCpuIdlePressure() )
+  {
+    target = active / 2u;
+  }
+  else if( active < room )
+  {
+    ++target;
+  }
+  target = std::min( target, room );
 
-    updateHashrate();
+  if( target == active ) { return; }
 
-    if( bswap64( reinterpret_cast<uint64_t&>(out_buffer[0]) ) < m_target )
+  if( target == 0u )
+  {
+    Log::pushLog( "CPU mining paused; the system is busy."s );
+  }
+  else if( active == 0u )
+  {
+    Log::pushLog( "CPU mining resumed."s );
+  }
+  setThreadCount( target );
+}
+
+auto CPUSolver::claimWork( worker_t& self, uint64_t const& epoch ) -> uint64_t
+{
+  {
+    guard lock{ self.range_mutex };
+    if( self.epoch == epoch && self.next < self.end )
     {
-      MinerState::pushSolution( solution );
+      self.next += STEP_SIZE;
+      return self.next - STEP_SIZE;
     }
   }
-  while( !m_stop );
+
+  // out of work: take the top half of the first sibling range still worth
+  // splitting, so retired and slow workers don't strand their nonces
+  uint64_t base{ 0u }, end{ 0u };
+  for( auto const& victim : m_workers )
+  {
+    if( victim.get() == &self ) { continue; }
+
+    guard lock{ victim->range_mutex };
+    if( victim->epoch != epoch || victim->end - victim->next < 2u * STEP_SIZE ) { continue; }
+
+    uint64_t const half{ (victim->end - victim->next) / 2u / STEP_SIZE * STEP_SIZE };
+    end = victim->end;
+    base = victim->end -= half;
+    break;
+  }
+
+  // nothing to steal, so lease a fresh block
+  if( end == 0u )
+  {
+    base = MinerState::getIncSearchSpace( m_lease_size );
+    end = base + m_lease_size;
+  }
+
+  guard lock{ self.range_mutex };
+  self.epoch = epoch;
+  self.next = base + STEP_SIZE;
+  self.end = end;
+  return base;
 }
 
-auto CPUSolver::startFinding() -> void
+auto CPUSolver::runWorker( worker_t& self ) -> void
 {
-  m_run_thread = std::thread( &CPUSolver::findSolution, this );
+  // pin first, so the working state below is faulted in on this
+  // thread's own NUMA node
+  if( self.cpu >= 0 && !SetThreadAffinity( static_cast<uint32_t>( self.cpu ) ) )
+  {
+    Log::pushLog( "Unable to pin CPU thread to logical CPU "s + std::to_string( self.cpu ) + "."s );
+  }
+
+  if( MinerState::getCpuIdle() && !SetThreadIdlePriority() )
+  {
+    Log::pushLog( "Unable to lower CPU thread priority."s );
+  }
+
+  uint64_t epoch{ ~0ull };
+  std::shared_ptr<job_t const> job;
+  std::shared_ptr<Nabiki::Keccak::jit_kernel_t const> jit;
+  uint64_t job_gen{ ~0ull };
+  uint32_t solution_count{ 0u };
+  uint64_t solutions[256];
+
+  while( !self.stop && !m_stop )
+  {
+    // leases are tied to the epoch, so whatever is left of the old one is
+    // dropped here, one step after the message changes
+    if( m_epoch.load( std::memory_order_acquire ) != epoch )
+    {
+      bool const starting{ epoch == ~0ull };
+      epoch = m_epoch.load( std::memory_order_acquire );
+      if( !starting )
+      {
+        noteSwitch( epoch );
+      }
+    }
+
+    if( m_job_gen.load( std::memory_order_acquire ) != job_gen )
+    {
+      guard lock{ m_job_mutex };
+      job_gen = m_job_gen.load( std::memory_order_relaxed );
+      job = m_job;
+      jit = m_jit;
+    }
+
+    uint64_t const base{ claimWork( self, epoch ) };
+    if( jit )
+    {
+      jit->mine( base, STEP_SIZE, solutions, solution_count );
+    }
+    else
+    {
+      m_kernel.mine( job->midstate, job->target_num,
+                     base, STEP_SIZE, solutions, solution_count );
+    }
+
+    self.hashes.fetch_add( STEP_SIZE, std::memory_order_relaxed );
+
+    if( solution_count > 0u )
+    {
+      MinerState::pushSolutions( solutions, solution_count, job->epoch );
+      solution_count = 0u;
+    }
+  }
 }
@@ -26,36 +26,57 @@
 
 #include "miner_state.h"
 #include "types.h"
-#include "sph_keccak.h"
+#include "cpukernel.h"
 #include "isolver.h"
 #include "devicetelemetry.h"
 
 #include <cstdint>
 #include <cmath>
+#include <array>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 #include <atomic>
 #include <thread>
-
+#include <mutex>
+#include <condition_variable>
+
+// All CPU mining goes through a single solver, which runs one worker
+// thread per entry of `cpus` and reports as one device. Each worker hashes
+// nonces from its own range; once that runs dry it steals half of a
+// sibling's range, and only leases a new block from MinerState when
+// there's nothing left to steal.
 class CPUSolver : public ISolver
 {
 public:
-  CPUSolver() noexcept :
-    CPUSolver( 1 )
-  {}
-  CPUSolver( double const& intensity ) noexcept;
+  CPUSolver( double const& intensity, std::vector<int32_t> const& cpus ) noexcept;
   ~CPUSolver();
 
+  // mines on the calling thread, as the first worker
   auto findSolution() -> void final;
 
   auto startFinding() -> void final;
-  auto inline stopFinding() -> void final
-  { m_stop = true; }
+  auto stopFinding() -> void final;
+
+  // starts or stops workers so that `count` of them are running, up to
+  // the number the solver was built with
+  auto setThreadCount( uint32_t const& count ) -> void;
+  auto inline getThreadCount() const -> uint32_t
+  { return m_active; }
 
   auto inline getName() const -> std::string const& final
-  { return m_telemetry_handle->getName(); }
+  { return m_name; }
+  // 10-second average, in MH/s
   auto inline getHashrate() -> double const final
-  { return m_hash_average.load( std::memory_order_acquire ) * 1000000.0; }
+  { return getHashrate( std::chrono::seconds( 10 ) ); }
+  // average over the last `window`, up to 15 minutes, in MH/s
+  auto getHashrate( std::chrono::seconds const& window ) -> double const;
+  auto getHashCount() -> uint64_t const final;
+  auto getLaunchTime() -> double const final;
+  // for the slowest worker to pick up the last message
+  auto inline getSwitchTime() -> double const final
+  { return m_switch_time.load( std::memory_order_acquire ); }
 
   auto inline getClockMem() const -> uint32_t const final
   { return m_telemetry_handle->getClockMem(); }
@@ -70,63 +91,80 @@ public:
   auto inline getIntensity() const -> double const final
   { return m_intensity; }
 
-  auto inline updateTarget() -> void final
-  { m_new_target = true; }
-  auto inline updateMessage() -> void final
-  { m_new_message = true; }
+  auto updateTarget() -> void final;
+  auto updateMessage() -> void final;
 
 private:
-  //CPUSolver() = delete;
+  CPUSolver() = delete;
   CPUSolver( CPUSolver const& ) = delete;
   CPUSolver& operator=( CPUSolver const& ) = delete;
 
-  auto inline updateHashrate() -> void
+  // workers are allocated on their own lines, and split in two: the
+  // first half only ever written by the owner (and the pool, rarely), the
+  // second shared with any sibling stealing from it
+  struct alignas(CACHE_LINE_SIZE) worker_t
   {
-    using namespace std::chrono;
-
-    if( m_hash_count_samples < 100 )
-    {
-      ++m_hash_count_samples;
-    }
-
-    m_hash_count += m_threads;
-    temp_time = static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - m_start).count()) / 1000000000;
-
-    temp_average = m_hash_average.load( std::memory_order_acquire );
-    temp_average += ((m_hash_count / temp_time) - temp_average) / m_hash_count_samples;
-    if( !std::isnan( temp_average ) && !std::isinf( temp_average ) )
-    {
-      m_hash_average.store( temp_average, std::memory_order_release );
-    }
-  }
+    std::atomic<uint64_t> hashes;
+    std::atomic<bool> stop;
+    int32_t cpu;
+    std::thread thread;
+
+    // the unclaimed part of this worker's nonce range, and the message
+    // epoch it was leased under; siblings may take from the top of it
+    alignas(CACHE_LINE_SIZE) std::mutex range_mutex;
+    uint64_t epoch;
+    uint64_t next;
+    uint64_t end;
+  };
+
+  auto runWorker( worker_t& self ) -> void;
+  auto runSampler() -> void;
+  auto noteSwitch( uint64_t const& epoch ) -> void;
+  auto throttle() -> void;
+  auto claimWork( worker_t& self, uint64_t const& epoch ) -> uint64_t;
+  auto loadJob() -> void;
 
   std::unique_ptr<IDeviceTelemetry> m_telemetry_handle;
+  Nabiki::Keccak::kernel_t const& m_kernel;
+  bool m_use_jit;
+  std::string m_name;
 
-  bool m_stop;
-  bool m_new_target;
-  bool m_new_message;
-  bool m_device_initialized;
-
-  double temp_time;
-  double temp_average;
-  uint64_t m_hash_count;
-  uint64_t m_hash_count_samples;
-  std::atomic<double> m_hash_average;
-
-  uint64_t m_target;
-  message_t m_message;
-
-  uint32_t h_solution_count;
-  uint64_t h_solutions[256];
-
+  // read by every worker on every step, written only on new work
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> m_stop;
+  std::atomic<uint64_t> m_epoch;
   double m_intensity;
-  uint64_t m_threads;
-
-  std::thread m_run_thread;
-
-  std::chrono::steady_clock::time_point m_start;
-
-  sph_keccak256_context m_ctx;
+  uint64_t m_lease_size;
+
+  // the job being hashed and, with "cpu_jit", code generated for it,
+  // both replaced whenever the message or target changes; workers fetch
+  // the pair again once m_job_gen moves on, and use m_kernel while m_jit
+  // is null
+  std::shared_ptr<job_t const> m_job;
+  std::shared_ptr<Nabiki::Keccak::jit_kernel_t const> m_jit;
+  std::mutex m_job_mutex;
+  std::atomic<uint64_t> m_job_gen;
+
+  // steady_clock time of the last updateMessage(), the epoch it started,
+  // and the latest any worker took to move over to it, all in ms; the
+  // first worker over resets the time, the rest only raise it
+  std::atomic<double> m_switch_start;
+  std::atomic<uint64_t> m_switch_epoch;
+  std::atomic<double> m_switch_time;
+
+  // sized once in the constructor, so siblings can be walked without
+  // locking the pool; workers past m_active are stopped
+  std::vector<std::unique_ptr<worker_t>> m_workers;
+  std::mutex m_pool_mutex;
+  std::atomic<uint32_t> m_active;
+
+  // the workers only bump their own integer counters; once a second the
+  // sampler totals them into a 15-minute ring, which getHashrate() reads
+  alignas(CACHE_LINE_SIZE) std::thread m_sampler;
+  std::mutex m_sample_mutex;
+  std::condition_variable m_sample_cv;
+  std::array<uint64_t, 15u * 60u + 1u> m_samples;
+  size_t m_sample_head;
+  size_t m_sample_count;
 };
 
 #endif // !_SOLVER_H_
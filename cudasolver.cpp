@@ -42,13 +42,18 @@ CUDASolver::CUDASolver( int32_t const& device, double const& intensity ) :
   m_stop( false ),
   m_new_target( true ),
   m_new_message( true ),
+  m_switch_start( 0. ),
+  m_switch_time( 0. ),
   m_device_initialized( false ),
   m_hash_count( 0u ),
   m_working_time( 0u ),
+  m_launch_count( 0u ),
   h_solution_count( 0u ),
   h_solutions(),
   m_intensity( intensity <= 41.99 ? intensity : 41.99 ),
-  m_threads( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity )) ),
+  m_threads( intensity == 1 ? 1 : static_cast<uint64_t>(std::pow( 2, m_intensity.load() )) ),
+  m_sizer( 0., 1u, 1u ),
+  m_last_launch( 0. ),
   m_grid( 1u ),
   m_block( 1024u ),
   d_mid( 0u ),
@@ -64,6 +69,8 @@ CUDASolver::CUDASolver( int32_t const& device, double const& intensity ) :
   }
 
   m_grid = uint32_t( (m_threads + m_block - 1) / m_block );
+  m_sizer = LaunchSizer( MinerState::getLaunchTarget(), m_block,
+                         static_cast<uint64_t>(std::pow( 2, 41.99 )) );
 
   cuSafeCall( cu.DeviceGet( &m_device, device ) );
   cuSafeCall( cu.CtxCreate( &m_context, CU_CTX_BLOCKING_SYNC, m_device ) );
@@ -103,7 +110,10 @@ CUDASolver::~CUDASolver()
 auto CUDASolver::findSolution() -> void
 {
   uint64_t t_target{ 0u };
-  state_t t_mid{ 0u };
+  midstate_t t_mid{ 0u };
+  std::shared_ptr<job_t const> job{ MinerState::getJob() };
+  // each round times the launch before it
+  uint64_t previous_threads{ m_threads };
 
   cuSafeCall( cu.CtxSetCurrent( m_context ) );
 
@@ -113,19 +123,16 @@ auto CUDASolver::findSolution() -> void
 
   do
   {
-    if( m_new_target )
+    // midstate and target always come from the same job, so a new
+    // challenge never goes out against an old target or the reverse
+    bool const switching{ m_new_message.exchange( false ) };
+    if( m_new_target.exchange( false ) || switching )
     {
-      t_target = MinerState::getTargetNum();
+      job = MinerState::getJob();
+      t_target = job->target_num;
+      t_mid = job->midstate;
       cuSafeCall( cu.MemcpyHtoDAsync( d_target, &t_target, sizeof( t_target ), m_stream ) );
-
-      m_new_target = false;
-    }
-    if( m_new_message )
-    {
-      t_mid = MinerState::getMidstate();
       cuSafeCall( cu.MemcpyHtoDAsync( d_mid, &t_mid, sizeof( t_mid ), m_stream ) );
-
-      m_new_message = false;
     }
 
     h_threads = MinerState::getIncSearchSpace( m_threads );
@@ -133,7 +140,24 @@ auto CUDASolver::findSolution() -> void
 
     cuSafeCall( cu.LaunchKernel( m_kernel, m_grid, 1u, 1u, m_block, 1u, 1u, 0u, m_stream, nullptr, nullptr ) );
 
-    updateHashrate();
+    if( switching )
+    {
+      m_switch_time.store( duration<double, std::milli>( steady_clock::now().time_since_epoch() ).count() -
+                           m_switch_start.load( std::memory_order_acquire ), std::memory_order_release );
+    }
+
+    // m_last_launch is the time of the launch before this one, so size
+    // from that launch's thread count, not the one just queued
+    uint64_t const timed_threads{ previous_threads };
+    updateHashrate( timed_threads );
+    previous_threads = m_threads;
+
+    if( m_sizer.isEnabled() )
+    {
+      m_threads = m_sizer.next( timed_threads, m_last_launch );
+      m_grid = uint32_t( m_threads / m_block );
+      m_intensity = std::log2( static_cast<double>( m_threads ) );
+    }
 
     cuSafeCall( cu.StreamSynchronize( m_stream ) );
     //cuSafeCall( cu.CtxSynchronize() );
@@ -145,7 +169,7 @@ auto CUDASolver::findSolution() -> void
     }
 
     cuSafeCall( cu.MemcpyDtoHAsync( &h_solutions, d_solutions, h_solution_count * sizeof( *h_solutions ), m_stream ) );
-    MinerState::pushSolution( std::vector<uint64_t>{ h_solutions, h_solutions + h_solution_count } );
+    MinerState::pushSolutions( h_solutions, h_solution_count, job->epoch );
     cudaResetSolution();
   }
   while( !m_stop );
@@ -155,7 +179,7 @@ auto CUDASolver::findSolution() -> void
   m_device_initialized = false;
 
   guard lock{ m_hashrate_mutex };
-  m_working_time = m_hash_count = 0;
+  m_working_time = m_hash_count = m_launch_count = 0;
 }
 
 auto CUDASolver::startFinding() -> void
@@ -174,16 +198,18 @@ auto CUDASolver::cudaResetSolution() -> void
   cuSafeCall( cu.MemcpyHtoDAsync( d_solution_count, &h_solution_count, sizeof( h_solution_count ), m_stream ) );
 }
 
-auto CUDASolver::updateHashrate() -> void
+auto CUDASolver::updateHashrate( uint64_t const& threads ) -> void
 {
   using namespace std::chrono;
 
   // goofy, yes; but it results in timing the _entire loop_
   m_round_end = steady_clock::now();
+  m_last_launch = duration<double, std::milli>( m_round_end - m_round_start ).count();
   {
     guard lock{ m_hashrate_mutex };
     m_working_time += static_cast<uint64_t>((m_round_end - m_round_start).count());
-    m_hash_count += m_threads;
+    m_hash_count += threads;
+    ++m_launch_count;
   }
   m_round_start = steady_clock::now();
 }
@@ -27,6 +27,7 @@
 #include "types.h"
 #include "isolver.h"
 #include "devicetelemetry.h"
+#include "launchsizer.h"
 #include "DynamicLibs/dlcuda.h"
 
 #include <cstdint>
@@ -57,6 +58,16 @@ public:
     guard lock{ m_hashrate_mutex };
     return static_cast<double>(m_hash_count) / (static_cast<double>(m_working_time) / 1e3);
   }
+  auto getHashCount() -> uint64_t const final
+  {
+    guard lock{ m_hashrate_mutex };
+    return m_hash_count;
+  }
+  auto getLaunchTime() -> double const final
+  {
+    guard lock{ m_hashrate_mutex };
+    return m_launch_count ? static_cast<double>(m_working_time) / 1e6 / static_cast<double>(m_launch_count) : 0.;
+  }
 
   auto getClockMem() const -> uint32_t const final
   { return m_telemetry_handle->getClockMem(); }
@@ -74,7 +85,13 @@ public:
   auto updateTarget() -> void final
   { m_new_target = true; }
   auto updateMessage() -> void final
-  { m_new_message = true; }
+  {
+    m_switch_start.store( std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now().time_since_epoch() ).count(), std::memory_order_release );
+    m_new_message = true;
+  }
+  auto getSwitchTime() -> double const final
+  { return m_switch_time.load( std::memory_order_acquire ); }
 
 private:
   CUDASolver() = delete;
@@ -83,17 +100,24 @@ private:
 
   auto cudaResetSolution() -> void;
 
-  auto updateHashrate() -> void;
+  // `threads` is the size of the launch being timed, which with
+  // "launch_target" needn't be the size of the next
+  auto updateHashrate( uint64_t const& threads ) -> void;
 
   std::unique_ptr<IDeviceTelemetry> m_telemetry_handle;
 
   bool m_stop;
-  bool m_new_target;
-  bool m_new_message;
+  std::atomic<bool> m_new_target;
+  std::atomic<bool> m_new_message;
+  // steady_clock time of the last updateMessage(), and how long after it
+  // the new work went out, both in ms
+  std::atomic<double> m_switch_start;
+  std::atomic<double> m_switch_time;
   bool m_device_initialized;
 
   uint64_t m_hash_count;
   uint64_t m_working_time;
+  uint64_t m_launch_count;
   std::mutex m_hashrate_mutex;
 
   CUdevice m_device;
@@ -105,8 +129,11 @@ private:
   uint64_t h_solution_count;
   uint64_t h_solutions[256];
 
-  double m_intensity;
+  // log2 of m_threads, which "launch_target" moves as it goes
+  std::atomic<double> m_intensity;
   uint64_t m_threads;
+  LaunchSizer m_sizer;
+  double m_last_launch;
 
   std::thread m_run_thread;
 
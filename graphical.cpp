@@ -212,16 +212,6 @@ namespace
         break;
       case WM_APP_UPDATE_HASHRATE:
         {
-          static auto time_counter{ steady_clock::now() + 100ms };
-          if( time_counter > steady_clock::now() ) break;
-          time_counter = steady_clock::now() + 100ms;
-
-          hashrate = 0;
-          for( auto const& temp : MinerCore::getHashrates() )
-          {
-            hashrate += temp;
-          }
-
           GetNumberFormatW( LOCALE_USER_DEFAULT, NULL, std::to_wstring( hashrate ).c_str(), &fmtFloat, sHashrate, 16 );
           UpdateControl( hHashrateText, sHashrate );
           break;
@@ -420,8 +410,9 @@ namespace UI
     PostMessageW( hMainWindow, WM_APP_UPDATE_ADDRESS, NULL, NULL );
   }
 
-  auto UpdateHashrate( [[maybe_unused]] uint64_t const& count ) -> void
+  auto UpdateHashrate( double const& rate, [[maybe_unused]] uint64_t const& count ) -> void
   {
+    hashrate = rate;
     PostMessageW( hMainWindow, WM_APP_UPDATE_HASHRATE, NULL, NULL );
   }
 
@@ -37,6 +37,12 @@ public:
 
   auto virtual getName() const -> std::string const& = 0;
   auto virtual getHashrate() -> double const = 0;
+  // nonces hashed so far; starts over from 0 if the solver is restarted
+  auto virtual getHashCount() -> uint64_t const = 0;
+  // wall time of one kernel launch (for CPUs, one worker's batch), in ms
+  auto virtual getLaunchTime() -> double const = 0;
+  // how long after the last updateMessage() hashing on it began, in ms
+  auto virtual getSwitchTime() -> double const = 0;
 
   auto virtual getClockMem() const -> uint32_t const = 0;
   auto virtual getClockCore() const -> uint32_t const = 0;
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _KECCAK_KERNEL_H_
+#define _KECCAK_KERNEL_H_
+
+// The keccak mining kernel, written once in the subset of C that host C++,
+// OpenCL C and CUDA all accept. Given the 30-word midstate (see midstate.h)
+// and a nonce, keccak_mine() returns the leading 64 bits of the digest,
+// byte-swapped so they compare against the target as a plain integer.
+//
+// Everything that differs between the three is behind a KK_ macro:
+//   KK_U64          a 64-bit unsigned integer
+//   KK_C( x )       a 64-bit unsigned literal
+//   KK_FN           qualifiers for a kernel helper function
+//   KK_DATA         storage for the round constant table
+//   KK_MID          address space of the midstate pointer
+//   KK_ROTL( x, n ) rotate left by a constant 0 < n < 64
+//   KK_XOR3( a, b, c ), KK_XOR5( a, b, c, d, e )
+//   KK_CHI( a, b, c ) a ^ (~b & c)
+//   KK_BSWAP64( x )
+//
+// CUDA and the host get their definitions below and the code itself. The
+// OpenCL program is built from a string at run time, so clsolver.cl
+// defines KECCAK_KERNEL_AS_STRING before including this, gets the code as
+// keccakKernelSource, and prepends its own KK_ definitions (rotate() and
+// bitselect()). The code can hold no preprocessor directives, as it is an
+// argument to a macro.
+#if defined KECCAK_KERNEL_AS_STRING
+#  define KECCAK_KERNEL( ... ) static char const keccakKernelSource[]{ #__VA_ARGS__ };
+
+#elif defined __CUDACC__
+#  define KECCAK_KERNEL( ... ) __VA_ARGS__
+
+#  define KK_U64 unsigned long long
+#  define KK_C( x ) x##ull
+#  define KK_FN __device__ __forceinline__
+#  define KK_DATA __constant__
+#  define KK_MID
+#  define KK_ROTL( x, n ) (((x) << (n)) | ((x) >> (64 - (n))))
+#  define KK_XOR3( a, b, c ) kk_xor3( a, b, c )
+#  define KK_XOR5( a, b, c, d, e ) KK_XOR3( KK_XOR3( a, b, c ), d, e )
+#  define KK_CHI( a, b, c ) kk_chi( a, b, c )
+#  define KK_BSWAP64( x ) kk_bswap64( x )
+
+// Maxwell and later evaluate any three-input bitwise function in one
+// LOP3, given its truth table over 0xF0, 0xCC and 0xAA. It only comes in
+// 32 bits, so a 64-bit lane takes one for each half.
+#  if defined __CUDA_ARCH__ && __CUDA_ARCH__ >= 500
+#    define KK_LOP3( lut, r, a, b, c )                                                      \
+       asm( "lop3.b32 %0, %1, %2, %3, " #lut ";" : "=r"(r.x) : "r"(a.x), "r"(b.x), "r"(c.x) ); \
+       asm( "lop3.b32 %0, %1, %2, %3, " #lut ";" : "=r"(r.y) : "r"(a.y), "r"(b.y), "r"(c.y) )
+#  endif // __CUDA_ARCH__ >= 500
+
+__device__ __forceinline__
+auto kk_xor3( KK_U64 const a, KK_U64 const b, KK_U64 const c ) -> KK_U64
+{
+#  if defined KK_LOP3
+  uint2 r;
+  KK_LOP3( 0x96, r, reinterpret_cast<uint2 const&>(a), reinterpret_cast<uint2 const&>(b), reinterpret_cast<uint2 const&>(c) );
+  return reinterpret_cast<KK_U64&>(r);
+#  else
+  return a ^ b ^ c;
+#  endif
+}
+
+__device__ __forceinline__
+auto kk_chi( KK_U64 const a, KK_U64 const b, KK_U64 const c ) -> KK_U64
+{
+#  if defined KK_LOP3
+  uint2 r;
+  KK_LOP3( 0xD2, r, reinterpret_cast<uint2 const&>(a), reinterpret_cast<uint2 const&>(b), reinterpret_cast<uint2 const&>(c) );
+  return reinterpret_cast<KK_U64&>(r);
+#  else
+  return a ^ (~b & c);
+#  endif
+}
+
+__device__ __forceinline__
+auto kk_bswap64( KK_U64 const x ) -> KK_U64
+{
+  return KK_U64( __byte_perm( unsigned( x ), 0u, 0x0123u ) ) << 32 | __byte_perm( unsigned( x >> 32 ), 0u, 0x0123u );
+}
+
+#else // host
+#  include "platforms.h"
+
+#  include <cstdint>
+
+#  define KECCAK_KERNEL( ... ) __VA_ARGS__
+
+#  define KK_U64 uint64_t
+#  define KK_C( x ) x##ull
+#  define KK_FN static inline
+#  define KK_DATA static
+#  define KK_MID
+#  define KK_ROTL( x, n ) rotl64( x, n )
+#  define KK_XOR3( a, b, c ) ((a) ^ (b) ^ (c))
+#  define KK_XOR5( a, b, c, d, e ) ((a) ^ (b) ^ (c) ^ (d) ^ (e))
+#  define KK_CHI( a, b, c ) ((a) ^ (~(b) & (c)))
+#  define KK_BSWAP64( x ) bswap64( x )
+
+#endif // host
+
+KECCAK_KERNEL(
+
+KK_DATA KK_U64 const keccak_rc[24] = {
+  KK_C( 0x0000000000000001 ), KK_C( 0x0000000000008082 ), KK_C( 0x800000000000808a ),
+  KK_C( 0x8000000080008000 ), KK_C( 0x000000000000808b ), KK_C( 0x0000000080000001 ),
+  KK_C( 0x8000000080008081 ), KK_C( 0x8000000000008009 ), KK_C( 0x000000000000008a ),
+  KK_C( 0x0000000000000088 ), KK_C( 0x0000000080008009 ), KK_C( 0x000000008000000a ),
+  KK_C( 0x000000008000808b ), KK_C( 0x800000000000008b ), KK_C( 0x8000000000008089 ),
+  KK_C( 0x8000000000008003 ), KK_C( 0x8000000000008002 ), KK_C( 0x8000000000000080 ),
+  KK_C( 0x000000000000800a ), KK_C( 0x800000008000000a ), KK_C( 0x8000000080008081 ),
+  KK_C( 0x8000000000008080 ), KK_C( 0x0000000080000001 ), KK_C( 0x8000000080008008 )
+};
+
+KK_FN void keccak_chi( KK_U64* const s, KK_U64 const* const b )
+{
+  s[0] = KK_CHI( b[0], b[1], b[2] );
+  s[1] = KK_CHI( b[1], b[2], b[3] );
+  s[2] = KK_CHI( b[2], b[3], b[4] );
+  s[3] = KK_CHI( b[3], b[4], b[0] );
+  s[4] = KK_CHI( b[4], b[0], b[1] );
+}
+
+// round 0 from the midstate: the nonce goes back into the lanes it reaches,
+// and the folded chi outputs come straight from mid[25..29]
+KK_FN void keccak_first( KK_U64* const s, KK_MID KK_U64 const* const mid, KK_U64 const nonce )
+{
+  KK_U64 b[5];
+
+  b[0] = mid[ 0];
+  b[1] = mid[ 1];
+  b[2] = mid[ 2] ^ KK_ROTL( nonce, 44 );
+  b[3] = mid[ 3];
+  b[4] = mid[ 4] ^ KK_ROTL( nonce, 14 );
+  keccak_chi( s, b );
+  s[ 0] ^= keccak_rc[0];
+  s[ 4] = mid[25] ^ KK_ROTL( nonce, 14 );
+
+  b[0] = mid[ 5];
+  b[1] = mid[ 6] ^ KK_ROTL( nonce, 20 );
+  b[2] = mid[ 7];
+  b[3] = mid[ 8];
+  b[4] = mid[ 9] ^ KK_ROTL( nonce, 62 );
+  keccak_chi( s + 5, b );
+  s[ 6] = mid[26] ^ KK_ROTL( nonce, 20 );
+
+  b[0] = mid[10];
+  b[1] = mid[11] ^ KK_ROTL( nonce,  7 );
+  b[2] = mid[12];
+  b[3] = mid[13] ^ KK_ROTL( nonce,  8 );
+  b[4] = mid[14];
+  keccak_chi( s + 10, b );
+  s[13] = mid[27] ^ KK_ROTL( nonce,  8 );
+
+  b[0] = mid[15] ^ KK_ROTL( nonce, 27 );
+  b[1] = mid[16];
+  b[2] = mid[17];
+  b[3] = mid[18] ^ KK_ROTL( nonce, 16 );
+  b[4] = mid[19];
+  keccak_chi( s + 15, b );
+  s[15] = mid[28] ^ KK_ROTL( nonce, 27 );
+
+  b[0] = mid[20] ^ KK_ROTL( nonce, 63 );
+  b[1] = mid[21] ^ KK_ROTL( nonce, 55 );
+  b[2] = mid[22] ^ KK_ROTL( nonce, 39 );
+  b[3] = mid[23];
+  b[4] = mid[24];
+  keccak_chi( s + 20, b );
+  s[22] = mid[29] ^ KK_ROTL( nonce, 39 );
+}
+
+KK_FN void keccak_round( KK_U64* const s, KK_U64 const rc )
+{
+  KK_U64 c[5], d, t;
+  int x;
+
+  for( x = 0; x < 5; ++x )
+  {
+    c[x] = KK_XOR5( s[x], s[x + 5], s[x + 10], s[x + 15], s[x + 20] );
+  }
+  for( x = 0; x < 5; ++x )
+  {
+    d = KK_ROTL( c[(x + 1) % 5], 1 );
+    s[x     ] = KK_XOR3( s[x     ], d, c[(x + 4) % 5] );
+    s[x +  5] = KK_XOR3( s[x +  5], d, c[(x + 4) % 5] );
+    s[x + 10] = KK_XOR3( s[x + 10], d, c[(x + 4) % 5] );
+    s[x + 15] = KK_XOR3( s[x + 15], d, c[(x + 4) % 5] );
+    s[x + 20] = KK_XOR3( s[x + 20], d, c[(x + 4) % 5] );
+  }
+
+  t = s[1];
+  s[ 1] = KK_ROTL( s[ 6], 44 );
+  s[ 6] = KK_ROTL( s[ 9], 20 );
+  s[ 9] = KK_ROTL( s[22], 61 );
+  s[22] = KK_ROTL( s[14], 39 );
+  s[14] = KK_ROTL( s[20], 18 );
+  s[20] = KK_ROTL( s[ 2], 62 );
+  s[ 2] = KK_ROTL( s[12], 43 );
+  s[12] = KK_ROTL( s[13], 25 );
+  s[13] = KK_ROTL( s[19],  8 );
+  s[19] = KK_ROTL( s[23], 56 );
+  s[23] = KK_ROTL( s[15], 41 );
+  s[15] = KK_ROTL( s[ 4], 27 );
+  s[ 4] = KK_ROTL( s[24], 14 );
+  s[24] = KK_ROTL( s[21],  2 );
+  s[21] = KK_ROTL( s[ 8], 55 );
+  s[ 8] = KK_ROTL( s[16], 45 );
+  s[16] = KK_ROTL( s[ 5], 36 );
+  s[ 5] = KK_ROTL( s[ 3], 28 );
+  s[ 3] = KK_ROTL( s[18], 21 );
+  s[18] = KK_ROTL( s[17], 15 );
+  s[17] = KK_ROTL( s[11], 10 );
+  s[11] = KK_ROTL( s[ 7],  6 );
+  s[ 7] = KK_ROTL( s[10],  3 );
+  s[10] = KK_ROTL( t,  1 );
+
+  for( x = 0; x < 25; x += 5 )
+  {
+    c[0] = s[x    ];
+    c[1] = s[x + 1];
+    c[2] = s[x + 2];
+    c[3] = s[x + 3];
+    c[4] = s[x + 4];
+    keccak_chi( s + x, c );
+  }
+
+  s[0] ^= rc;
+}
+
+// round 23 only has to produce lane 0, which depends on three lanes
+KK_FN KK_U64 keccak_last( KK_U64 const* const s )
+{
+  KK_U64 c[5], b[3];
+  int x;
+
+  for( x = 0; x < 5; ++x )
+  {
+    c[x] = KK_XOR5( s[x], s[x + 5], s[x + 10], s[x + 15], s[x + 20] );
+  }
+
+  b[0] = KK_XOR3( s[ 0], c[4], KK_ROTL( c[1], 1 ) );
+  b[1] = KK_ROTL( KK_XOR3( s[ 6], c[0], KK_ROTL( c[2], 1 ) ), 44 );
+  b[2] = KK_ROTL( KK_XOR3( s[12], c[1], KK_ROTL( c[3], 1 ) ), 43 );
+
+  return KK_BSWAP64( KK_CHI( b[0], b[1], b[2] ) ^ keccak_rc[23] );
+}
+
+KK_FN KK_U64 keccak_mine( KK_MID KK_U64 const* const mid, KK_U64 const nonce )
+{
+  KK_U64 s[25];
+  int r;
+
+  keccak_first( s, mid, nonce );
+  for( r = 1; r < 23; ++r )
+  {
+    keccak_round( s, keccak_rc[r] );
+  }
+  return keccak_last( s );
+}
+
+)
+
+#undef KECCAK_KERNEL
+
+#endif // !_KECCAK_KERNEL_H_
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _LAUNCHSIZER_H_
+#define _LAUNCHSIZER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Picks the work items for each GPU launch so that it takes about
+// `target_ms`: long enough to bury the host overhead between launches,
+// short enough that a new challenge is picked up quickly. The device's
+// rate is smoothed over recent launches, so clocks and thermals can drift
+// under it, and no launch is more than twice or half the size of the one
+// before. Sizes stay multiples of `granule` (a CUDA block, an OpenCL work
+// group) and no larger than `maximum`.
+class LaunchSizer
+{
+public:
+  LaunchSizer( double const& target_ms, uint64_t const& granule, uint64_t const& maximum ) noexcept :
+    m_target_ms( target_ms ),
+    m_granule( std::max( granule, uint64_t( 1u ) ) ),
+    m_maximum( std::max( maximum / m_granule * m_granule, m_granule ) ),
+    m_rate( 0. ),
+    m_seen_first( false )
+  {}
+
+  auto inline isEnabled() const -> bool
+  { return m_target_ms > 0.; }
+
+  // the size of the next launch, after one of `threads` took `ms`
+  auto next( uint64_t const& threads, double const& ms ) -> uint64_t
+  {
+    // the first launch carries the driver's own warm-up
+    if( !m_seen_first || ms <= 0. )
+    {
+      m_seen_first = true;
+      return threads;
+    }
+
+    double const rate{ static_cast<double>( threads ) / ms };
+    m_rate = m_rate > 0. ? m_rate * (1. - SMOOTHING) + rate * SMOOTHING : rate;
+
+    double const ideal{ std::clamp( m_rate * m_target_ms, threads / 2., threads * 2. ) };
+
+    // leave well alone when close, rather than chase noise
+    if( std::abs( ideal - threads ) < threads * DEADBAND ) { return threads; }
+
+    return std::clamp( static_cast<uint64_t>( ideal ) / m_granule * m_granule, m_granule, m_maximum );
+  }
+
+private:
+  static double constexpr SMOOTHING{ 0.2 };
+  static double constexpr DEADBAND{ 0.05 };
+
+  double m_target_ms;
+  uint64_t m_granule;
+  uint64_t m_maximum;
+  double m_rate;
+  bool m_seen_first;
+};
+
+#endif // !_LAUNCHSIZER_H_
@@ -25,7 +25,7 @@
 
 #include <cstdint>
 
-auto main( [[maybe_unused]] int argc, [[maybe_unused]] char* argv[] ) -> int32_t
+auto main( int argc, char* argv[] ) -> int32_t
 {
-return MinerCore::run();
+return MinerCore::run( argc, argv );
 }
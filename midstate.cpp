@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "midstate.h"
+#include "cpukernel.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace Nabiki::Keccak
+{
+  auto precompute( message_t const& message ) -> midstate_t
+  {
+    std::array<uint64_t, 25u> a{};
+    std::memcpy( a.data(), message.data(), message.size() );
+    a[NONCE_LANE] = 0u;
+    a[10] ^= 0x01ull << 32;
+    a[16] ^= 0x80ull << 56;
+
+    auto const B{ linearRound( a ) };
+
+    midstate_t mid{};
+    for( uint_fast8_t b{ 0u }; b < 25u; ++b )
+    {
+      mid[b] = B[b];
+    }
+    for( uint_fast8_t row{ 0u }; row < 5u; ++row )
+    {
+      uint_fast8_t const x{ FOLD_COLUMN[row] };
+      uint_fast8_t const lane{ static_cast<uint_fast8_t>(row * 5u + x) };
+      mid[25u + row] = B[lane] ^ (~B[row * 5u + (x + 1u) % 5u] & B[row * 5u + (x + 2u) % 5u]) ^
+                       (lane == 0u ? RC[0] : 0u);
+    }
+    return mid;
+  }
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _MIDSTATE_H_
+#define _MIDSTATE_H_
+
+#include "types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Everything the mining kernels can know about a message before they see
+// a nonce. The message is absorbed in a single block - 84 bytes, the 0x01
+// pad straight after and the closing 0x80 at the end of the 136-byte rate
+// - and the kernels vary only the low 64 bits of the nonce, which sit in
+// lane 8 (message bytes 64 to 71).
+//
+// Theta, rho and pi are linear, so round 0 can be run up to chi with the
+// nonce lane zeroed, and the nonce XORed back in afterwards wherever it
+// lands. Where it lands is worked out here at compile time by running the
+// same code over bit masks of nonce rotations. Each backend hard-codes the
+// resulting tables, and static_asserts keep the CPU ones honest.
+namespace Nabiki::Keccak
+{
+  inline size_t constexpr NONCE_LANE{ 8u };
+
+  // rho and pi: the state lane and rotation feeding each B of each row
+  inline uint8_t constexpr PI[25]{
+     0u,  6u, 12u, 18u, 24u,
+     3u,  9u, 10u, 16u, 22u,
+     1u,  7u, 13u, 19u, 20u,
+     4u,  5u, 11u, 17u, 23u,
+     2u,  8u, 14u, 15u, 21u
+  };
+  inline uint8_t constexpr RHO[25]{
+     0u, 44u, 43u, 21u, 14u,
+    28u, 20u,  3u, 45u, 61u,
+     1u,  6u, 25u,  8u, 18u,
+    27u, 36u, 10u, 15u, 56u,
+    62u, 55u, 39u, 41u,  2u
+  };
+
+  constexpr auto rotl( uint64_t const x, uint_fast8_t const n ) -> uint64_t
+  {
+    return n % 64u == 0u ? x : x << (n % 64u) | x >> (64u - n % 64u);
+  }
+
+  // Theta, rho and pi of one round, leaving the B lanes row by row. Given
+  // masks with bit r set for each rotl( nonce, r ) a lane holds, in place
+  // of lanes, it gives the same masks for the B lanes: XOR and rotation
+  // act on those exactly as they do on the values.
+  constexpr auto linearRound( std::array<uint64_t, 25u> const& a ) -> std::array<uint64_t, 25u>
+  {
+    uint64_t C[5]{}, D[5]{};
+    for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+    {
+      C[x] = a[x] ^ a[x + 5u] ^ a[x + 10u] ^ a[x + 15u] ^ a[x + 20u];
+    }
+    for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+    {
+      D[x] = C[(x + 4u) % 5u] ^ rotl( C[(x + 1u) % 5u], 1u );
+    }
+
+    std::array<uint64_t, 25u> B{};
+    for( uint_fast8_t b{ 0u }; b < 25u; ++b )
+    {
+      B[b] = rotl( a[PI[b]] ^ D[PI[b] % 5u], RHO[b] );
+    }
+    return B;
+  }
+
+  // the nonce rotations reaching each B lane of round 0
+  constexpr auto nonceReach() -> std::array<uint64_t, 25u>
+  {
+    std::array<uint64_t, 25u> a{};
+    a[NONCE_LANE] = 1u;
+    return linearRound( a );
+  }
+
+  // the rotation of the nonce XORed into each B lane of round 0, or -1
+  // where it doesn't reach
+  constexpr auto nonceRotations() -> std::array<int8_t, 25u>
+  {
+    auto const reach{ nonceReach() };
+    std::array<int8_t, 25u> rot{};
+    for( uint_fast8_t b{ 0u }; b < 25u; ++b )
+    {
+      rot[b] = -1;
+      for( int8_t r{ 0 }; r < 64; ++r )
+      {
+        if( reach[b] == 1ull << r ) { rot[b] = r; }
+      }
+    }
+    return rot;
+  }
+
+  // For each row of round 0's chi, the column whose and-not term has
+  // neither input touched by the nonce, or 5 if there is none. That
+  // output is then a constant XORed with the nonce rotation its own B
+  // lane carries.
+  constexpr auto foldColumns() -> std::array<uint8_t, 5u>
+  {
+    auto const reach{ nonceReach() };
+    std::array<uint8_t, 5u> fold{};
+    for( uint_fast8_t row{ 0u }; row < 5u; ++row )
+    {
+      fold[row] = 5u;
+      for( uint_fast8_t x{ 0u }; x < 5u; ++x )
+      {
+        if( reach[row * 5u + (x + 1u) % 5u] == 0u && reach[row * 5u + (x + 2u) % 5u] == 0u )
+        {
+          fold[row] = static_cast<uint8_t>(x);
+          break;
+        }
+      }
+    }
+    return fold;
+  }
+
+  inline auto constexpr NONCE_ROT{ nonceRotations() };
+  inline auto constexpr FOLD_COLUMN{ foldColumns() };
+
+  // every lane the nonce reaches carries exactly one rotation of it, and
+  // every row has a lane to fold; the kernels rely on both
+  static_assert( []{
+    auto const reach{ nonceReach() };
+    for( uint_fast8_t b{ 0u }; b < 25u; ++b )
+    {
+      if( reach[b] != 0u && NONCE_ROT[b] < 0 ) { return false; }
+    }
+    for( auto const& x : FOLD_COLUMN )
+    {
+      if( x > 4u ) { return false; }
+    }
+    return true;
+  }(), "nonce placement no longer fits the kernels" );
+
+  // The constants for one message, in the layout every backend uploads:
+  //   [ 0, 25) round 0's B lanes with the nonce lane zeroed
+  //   [25, 30) per row, the folded chi output (iota included) with the
+  //            nonce part left out
+  auto precompute( message_t const& message ) -> midstate_t;
+}
+
+#endif // !_MIDSTATE_H_
@@ -22,6 +22,10 @@
  */
 
 #include "miner_state.h"
+#include "midstate.h"
+#include "solutionring.h"
+#include "sharedwork.h"
+#include "stats.h"
 #include "log.h"
 #include "utils.h"
 #include "platforms.h"
@@ -42,6 +46,7 @@
 #include <random>
 #include <atomic>
 #include <chrono>
+#include <memory>
 #include <fstream>
 #include <string>
 #include <string_view>
@@ -64,9 +69,14 @@ namespace
     opencl_platforms{ { { "amd"sv, "AMD"sv }, { "nvidia"sv, "NVIDIA"sv }, { "intel"sv, "Intel"sv } } };
 
   static message_t m_message{};
-  static state_t m_midstate{};
-  static std::atomic<bool> m_midstate_ready{ false };
-  static std::mutex m_midstate_mutex;
+  // read with std::atomic_load only; m_job_mutex just keeps publishers
+  // from overtaking each other
+  static std::shared_ptr<job_t const> m_job{ std::make_shared<job_t const>() };
+  static std::mutex m_job_mutex;
+  // the last few jobs by epoch, so late solutions can still be checked
+  // against the message they were found for; under m_job_mutex
+  static size_t constexpr RECENT_JOBS{ 4u };
+  static std::array<std::shared_ptr<job_t const>, RECENT_JOBS> m_recent_jobs{};
   static hash_t m_challenge_old{};
   static std::mutex m_message_mutex;
   static std::atomic<bool> m_challenge_ready{ false };
@@ -83,14 +93,20 @@ namespace
   static std::mutex m_address_mutex;
   static std::string m_pool_url{};
   static std::mutex m_pool_url_mutex;
-  static std::mutex m_solutions_mutex;
-  static std::vector<std::string> m_solutions_queue{};
+  // solvers push from their own threads, the network thread pops; at a
+  // few shares a second, 4096 slots is minutes of headroom
+  static SolutionRing<4096u> m_solutions{};
+  static std::atomic<uint64_t> m_solutions_dropped{ 0ull };
   static hash_t m_solution{};
-  static std::atomic<uint64_t> m_hash_count{ 0ull };
   static std::condition_variable m_is_ready;
   static std::mutex m_is_ready_mutex;
 
-  static std::atomic<uint64_t> m_hash_count_printable{ 0ull };
+  // every device thread takes its nonces from here on each lease, so the
+  // counter gets a line to itself
+  static struct alignas(CACHE_LINE_SIZE)
+  {
+    std::atomic<uint64_t> next{ 0ull };
+  } m_nonces;
   static std::queue<std::string> m_log{};
   static std::mutex m_log_mutex;
   static steady_clock::time_point m_start{};
@@ -99,6 +115,14 @@ namespace
   static device_list_t m_cuda_devices{};
   static device_map_t m_opencl_devices{};
   static uint32_t m_cpu_threads{ 0ul };
+  static std::string m_cpu_kernel{};
+  static bool m_cpu_jit{ false };
+  static double m_cpu_intensity{ 20.0 };
+  static std::string m_cpu_affinity{ "auto" };
+  static std::vector<uint32_t> m_cpu_affinity_list{};
+  static uint32_t m_cpu_reserve{ 1u };
+  static bool m_cpu_idle{ false };
+  static double m_cpu_idle_pressure{ 10.0 };
   static std::string m_worker_name{};
   static std::string m_api_ports{};
   static std::string m_api_allowed{};
@@ -106,15 +130,21 @@ namespace
   static std::string m_token_name{ "0xBTC" };
   static bool m_submit_stale{ false };
   static bool m_debug{ false };
+  static uint32_t m_benchmark{ 0u };
+  static uint32_t m_autotune{ 0u };
+  static double m_launch_target{ 0. };
+  static std::string m_shared_memory{};
+
+  // bracket the "autotune" block in nabiki.json, so that it can be found
+  // and replaced without touching anything the user wrote
+  static std::string_view constexpr TUNING_BEGIN{ "  // ------- autotune begin"sv };
+  static std::string_view constexpr TUNING_END{ "  // ------- autotune end"sv };
 }
 
 // --------------------------------------------------------------------
 
 namespace MinerState
 {
-  template auto pushSolution( uint64_t const ) -> void;
-  template auto pushSolution( std::vector<uint64_t> const ) -> void;
-
   auto Init() -> void
   {
     std::ifstream in( "nabiki.json" );
@@ -127,25 +157,50 @@ namespace MinerState
     in >> m_json_config;
     in.close();
 
-    json::iterator iter{ m_json_config.find( "address" ) };
+    // --benchmark on the command line takes precedence
+    json::iterator iter{ m_json_config.find( "benchmark"s ) };
+    if( m_benchmark == 0u &&
+        iter != m_json_config.end() &&
+        iter->is_number_unsigned() )
+    {
+      m_benchmark = iter->get<uint32_t>();
+    }
+
+    // neither a benchmark nor --autotune talks to the pool, so they can
+    // do without either
+    bool const offline{ m_benchmark > 0u || m_autotune > 0u };
+
+    iter = m_json_config.find( "address" );
     if( iter == m_json_config.end() ||
         ( iter->is_string() &&
           iter->get<std::string>().length() != 42 ) )
     {
-      std::cerr << "No valid wallet address set in configuration - how are you supposed to get paid?\n"sv;
-      std::abort();
+      if( !offline )
+      {
+        std::cerr << "No valid wallet address set in configuration - how are you supposed to get paid?\n"sv;
+        std::abort();
+      }
+    }
+    else
+    {
+      setAddress( iter->get<std::string>() );
     }
-    setAddress( iter->get<std::string>() );
 
     iter = m_json_config.find( "pool" );
     if( iter == m_json_config.end() ||
         ( iter->is_string() &&
           iter->get<std::string>().length() < 15 ) )
     {
-      std::cerr << "No pool address set in configuration - this isn't a solo miner!\n"sv;
-      std::abort();
+      if( !offline )
+      {
+        std::cerr << "No pool address set in configuration - this isn't a solo miner!\n"sv;
+        std::abort();
+      }
+    }
+    else
+    {
+      setPoolUrl( iter->get<std::string>() );
     }
-    setPoolUrl( iter->get<std::string>() );
 
     // this has to come before diff is set
     iter = m_json_config.find( "token" );
@@ -175,6 +230,14 @@ namespace MinerState
       setSubmitStale( m_json_config["submitstale"].get<bool>() );
     }
 
+    iter = m_json_config.find( "launch_target"s );
+    if( iter != m_json_config.end() &&
+        iter->is_number() &&
+        iter->get<double>() > 0. )
+    {
+      m_launch_target = iter->get<double>();
+    }
+
     iter = m_json_config.find( "debug" );
     if( iter != m_json_config.end() &&
         iter->is_boolean() )
@@ -295,6 +358,70 @@ namespace MinerState
       m_cpu_threads = iter->get<uint32_t>();
     }
 
+    iter = m_json_config.find( "cpu_intensity"s );
+    if( iter != m_json_config.end() &&
+        iter->is_number() &&
+        iter->get<double>() > 0 )
+    {
+      m_cpu_intensity = iter->get<double>();
+    }
+
+    iter = m_json_config.find( "cpu_kernel"s );
+    if( iter != m_json_config.end() &&
+        iter->is_string() )
+    {
+      m_cpu_kernel = iter->get<std::string>();
+    }
+
+    iter = m_json_config.find( "cpu_jit"s );
+    if( iter != m_json_config.end() &&
+        iter->is_boolean() )
+    {
+      m_cpu_jit = iter->get<bool>();
+    }
+
+    iter = m_json_config.find( "cpu_affinity"s );
+    if( iter != m_json_config.end() )
+    {
+      if( iter->is_string() )
+      {
+        m_cpu_affinity = iter->get<std::string>();
+      }
+      else if( iter->is_array() )
+      {
+        m_cpu_affinity = "list"s;
+        for( auto const& cpu : *iter )
+        {
+          if( cpu.is_number_unsigned() )
+          {
+            m_cpu_affinity_list.emplace_back( cpu.get<uint32_t>() );
+          }
+        }
+      }
+    }
+
+    iter = m_json_config.find( "cpu_reserve"s );
+    if( iter != m_json_config.end() &&
+        iter->is_number_unsigned() )
+    {
+      m_cpu_reserve = iter->get<uint32_t>();
+    }
+
+    iter = m_json_config.find( "cpu_idle"s );
+    if( iter != m_json_config.end() &&
+        iter->is_boolean() )
+    {
+      m_cpu_idle = iter->get<bool>();
+    }
+
+    iter = m_json_config.find( "cpu_idle_pressure"s );
+    if( iter != m_json_config.end() &&
+        iter->is_number() &&
+        iter->get<double>() > 0 )
+    {
+      m_cpu_idle_pressure = iter->get<double>();
+    }
+
     iter = m_json_config.find( "worker_name"s );
     if( iter != m_json_config.end() &&
         iter->is_string() )
@@ -302,6 +429,16 @@ namespace MinerState
       m_worker_name = iter->get<std::string>();
     }
 
+    // offline runs have nothing to share, and shouldn't take nonces from
+    // instances that are mining
+    iter = m_json_config.find( "shared_memory"s );
+    if( !offline &&
+        iter != m_json_config.end() &&
+        iter->is_string() )
+    {
+      m_shared_memory = iter->get<std::string>();
+    }
+
     iter = m_json_config.find( "telemetry"s );
     if( iter != m_json_config.end() )
     {
@@ -369,6 +506,18 @@ namespace MinerState
 
     std::memset( &m_solution[12], 0, 8 );
 
+    if( !m_shared_memory.empty() )
+    {
+      if( Nabiki::SharedWork::Join( m_shared_memory, m_solution ) )
+      {
+        Log::pushLog( "Sharing work with other instances through \""s + m_shared_memory + "\"."s );
+      }
+      else
+      {
+        Log::pushLog( "Unable to open shared memory \""s + m_shared_memory + "\"; mining alone."s );
+      }
+    }
+
     {
       guard lock( m_message_mutex );
       std::memcpy( &m_message[52], m_solution.data(), 32 );
@@ -380,14 +529,17 @@ namespace MinerState
 
   auto getIncSearchSpace( uint64_t const& threads ) -> uint64_t const
   {
-    UI::UpdateHashrate( m_hash_count_printable.fetch_add( threads, std::memory_order_acq_rel ) );
+    if( Nabiki::SharedWork::IsJoined() )
+    {
+      return Nabiki::SharedWork::LeaseNonces( threads );
+    }
 
-    return m_hash_count.fetch_add( threads, std::memory_order_acq_rel );
+    return m_nonces.next.fetch_add( threads, std::memory_order_acq_rel );
   }
 
   auto resetCounter() -> void
   {
-    m_hash_count_printable.store( 0ull, std::memory_order_release );
+    Stats::NewRound();
 
     m_round_start = steady_clock::now();
   }
@@ -397,56 +549,36 @@ namespace MinerState
     return m_round_start;
   }
 
-  auto getPrintableHashCount() -> uint64_t const
+  auto drainSolutions( std::vector<found_t>& found ) -> void
   {
-    return m_hash_count_printable.load( std::memory_order_acquire );
-  }
-
-  auto getSolution() -> std::string
-  {
-    std::string retStr{};
-
-    if( !m_solutions_queue.empty() )
+    found_t sol;
+    while( m_solutions.pop( sol ) )
     {
-      guard lock( m_solutions_mutex );
-      retStr = m_solutions_queue.back();
-      m_solutions_queue.pop_back();
+      found.emplace_back( sol );
     }
 
-    return retStr;
-  }
-
-  auto getAllSolutions() -> std::vector<std::string>
-  {
-    std::vector<std::string> retVec;
-
-    if( !m_solutions_queue.empty() )
+    uint64_t const dropped{ m_solutions_dropped.exchange( 0ull, std::memory_order_acq_rel ) };
+    if( dropped > 0u )
     {
-      guard lock( m_solutions_mutex );
-      retVec.swap( m_solutions_queue );
+      Log::pushLog( "Solution queue full, dropped "s + std::to_string( dropped ) + " solution(s)."s );
     }
-
-    return retVec;
   }
 
-  template<typename T>
-  auto pushSolution( T const sols ) -> void
+  auto formatSolution( uint64_t const& nonce ) -> std::string
   {
-    static hash_t ret{ m_solution };
+    hash_t ret{ m_solution };
+    std::memcpy( &ret[12], &nonce, 8 );
+    return bytesToString( ret );
+  }
 
-    guard lock( m_solutions_mutex );
-    if constexpr( std::is_integral_v<T> )
-    {
-      std::memcpy( &ret[12], &sols, 8 );
-      m_solutions_queue.emplace_back( bytesToString( ret ) );
-    }
-    else
+  auto pushSolutions( uint64_t const* nonces, size_t const& count, uint64_t const& job ) noexcept -> void
+  {
+    for( size_t i{ 0u }; i < count; ++i )
     {
-      m_solutions_queue.reserve( sols.size() + m_solutions_queue.size() );
-      for( auto const& val : sols )
+      if( !m_solutions.push( { nonces[i], job } ) )
       {
-        std::memcpy( &ret[12], &val, 8 );
-        m_solutions_queue.emplace_back( bytesToString( ret ) );
+        m_solutions_dropped.fetch_add( count - i, std::memory_order_relaxed );
+        return;
       }
     }
   }
@@ -476,21 +608,6 @@ namespace MinerState
     return bytesToString( temp );
   }
 
-  auto getOldPrefix() -> std::string const
-  {
-    prefix_t temp;
-
-    {
-      guard lock( m_message_mutex );
-      //std::copy( m_challenge_old.begin(), m_challenge_old.begin() + 31, temp.begin() );
-      //std::copy( m_message.begin() + 31, m_message.begin() + 51, temp.begin() );
-      std::memcpy( temp.data(), m_challenge_old.data(), 32 );
-      std::memcpy( &temp[32], m_message.data(), 20 );
-    }
-
-    return bytesToString( temp );
-  }
-
   auto setChallenge( std::string_view const challenge ) -> void
   {
     hash_t temp;
@@ -507,12 +624,6 @@ namespace MinerState
       std::memmove( m_message.data(), temp.data(), 32 );
     }
 
-    if( !getSubmitStale() )
-    {
-      guard lock( m_solutions_mutex );
-      std::vector<std::string>().swap( m_solutions_queue );
-    }
-
     UI::UpdateChallenge( challenge.substr( 2, 8 ) );
 
     {
@@ -591,6 +702,16 @@ namespace MinerState
     }
 
     m_target_num.store( target.getBlock( 3 ), std::memory_order_release );
+
+    guard lock( m_job_mutex );
+    auto const current{ std::atomic_load_explicit( &m_job, std::memory_order_acquire ) };
+    if( current->epoch == 0u ) { return; }
+
+    auto job{ std::make_shared<job_t>( *current ) };
+    job->target = getTarget();
+    job->target_num = getTargetNum();
+    m_recent_jobs[job->epoch % RECENT_JOBS] = job;
+    std::atomic_store_explicit( &m_job, std::shared_ptr<job_t const>{ std::move( job ) }, std::memory_order_release );
   }
 
   auto getTarget() -> BigUnsigned const
@@ -621,67 +742,27 @@ namespace MinerState
         !m_pool_address_ready.load( std::memory_order_acquire ) )
     { return; }
 
-    std::array<uint64_t, 11> message{ 0 };
+    guard lock( m_job_mutex );
+    auto job{ std::make_shared<job_t>() };
+    job->epoch = std::atomic_load_explicit( &m_job, std::memory_order_acquire )->epoch + 1u;
+    job->message = getMessage();
+    job->midstate = Nabiki::Keccak::precompute( job->message );
+    job->target = getTarget();
+    job->target_num = getTargetNum();
+    m_recent_jobs[job->epoch % RECENT_JOBS] = job;
+    std::atomic_store_explicit( &m_job, std::shared_ptr<job_t const>{ std::move( job ) }, std::memory_order_release );
+  }
 
-    {
-      guard lock( m_message_mutex );
-      //std::copy( m_message.begin(), m_message.end(), reinterpret_cast<uint8_t*>( message.data() ) );
-      std::memcpy( message.data(), m_message.data(), 84 );
-    }
-
-    std::array<uint64_t, 25> mid;
-    uint64_t C[5], D[5];
-    C[0] = message[0] ^ message[5] ^ message[10] ^ 0x100000000ull;
-    C[1] = message[1] ^ message[6] ^ 0x8000000000000000ull;
-    C[2] = message[2] ^ message[7];
-    C[3] = message[3] ^ message[8];
-    C[4] = message[4] ^ message[9];
-
-    D[0] = rotl64( C[1], 1 ) ^ C[4];
-    D[1] = rotl64( C[2], 1 ) ^ C[0];
-    D[2] = rotl64( C[3], 1 ) ^ C[1];
-    D[3] = rotl64( C[4], 1 ) ^ C[2];
-    D[4] = rotl64( C[0], 1 ) ^ C[3];
-
-    mid[0] = message[0] ^ D[0];
-    mid[1] = rotl64( message[6] ^ D[1], 44 );
-    mid[2] = rotl64( D[2], 43 );
-    mid[3] = rotl64( D[3], 21 );
-    mid[4] = rotl64( D[4], 14 );
-    mid[5] = rotl64( message[3] ^ D[3], 28 );
-    mid[6] = rotl64( message[9] ^ D[4], 20 );
-    mid[7] = rotl64( message[10] ^ D[0] ^ 0x100000000ull, 3 );
-    mid[8] = rotl64( 0x8000000000000000ull ^ D[1], 45 );
-    mid[9] = rotl64( D[2], 61 );
-    mid[10] = rotl64( message[1] ^ D[1], 1 );
-    mid[11] = rotl64( message[7] ^ D[2], 6 );
-    mid[12] = rotl64( D[3], 25 );
-    mid[13] = rotl64( D[4], 8 );
-    mid[14] = rotl64( D[0], 18 );
-    mid[15] = rotl64( message[4] ^ D[4], 27 );
-    mid[16] = rotl64( message[5] ^ D[0], 36 );
-    mid[17] = rotl64( D[1], 10 );
-    mid[18] = rotl64( D[2], 15 );
-    mid[19] = rotl64( D[3], 56 );
-    mid[20] = rotl64( message[2] ^ D[2], 62 );
-    mid[21] = rotl64( message[8] ^ D[3], 55 );
-    mid[22] = rotl64( D[4], 39 );
-    mid[23] = rotl64( D[0], 41 );
-    mid[24] = rotl64( D[1], 2 );
-
-    {
-      guard lock( m_midstate_mutex );
-      //std::move( mid.begin(), mid.end(), reinterpret_cast<uint64_t*>(m_midstate.data()) );
-      std::memmove( m_midstate.data(), mid.data(), 200 );
-    }
-  }
-
-  auto getMidstate() -> state_t const
-  {
-    if( !m_midstate_ready ) setMidstate();
-
-    guard lock( m_midstate_mutex );
-    return m_midstate;
+  auto getRecentJob( uint64_t const& epoch ) -> std::shared_ptr<job_t const>
+  {
+    guard lock( m_job_mutex );
+    auto const& job{ m_recent_jobs[epoch % RECENT_JOBS] };
+    return job && job->epoch == epoch ? job : nullptr;
+  }
+
+  auto getJob() -> std::shared_ptr<job_t const>
+  {
+    return std::atomic_load_explicit( &m_job, std::memory_order_acquire );
   }
 
   auto setAddress( std::string_view const address ) -> void
@@ -767,6 +848,146 @@ namespace MinerState
     return m_cpu_threads;
   }
 
+  auto getCpuKernel() -> string_view
+  {
+    return m_cpu_kernel;
+  }
+
+  auto getCpuJit() -> bool const&
+  {
+    return m_cpu_jit;
+  }
+
+  auto getCpuIntensity() -> double const&
+  {
+    return m_cpu_intensity;
+  }
+
+  auto getCpuAffinity() -> string_view
+  {
+    return m_cpu_affinity;
+  }
+
+  auto getCpuAffinityList() -> std::vector<uint32_t> const&
+  {
+    return m_cpu_affinity_list;
+  }
+
+  auto getCpuReserve() -> uint32_t const&
+  {
+    return m_cpu_reserve;
+  }
+
+  auto getCpuIdle() -> bool const
+  {
+    // --autotune needs the thread count it set, at normal priority
+    return m_cpu_idle && m_autotune == 0u;
+  }
+
+  auto getCpuIdlePressure() -> double const&
+  {
+    return m_cpu_idle_pressure;
+  }
+
+  auto getLaunchTarget() -> double const
+  {
+    // --autotune needs every launch the size it asked for
+    return m_autotune > 0u ? 0. : m_launch_target;
+  }
+
+  auto getTuning( std::string const& device ) -> tuning_t const
+  {
+    tuning_t tuning{ 0., 0u, 0u };
+
+    json::const_iterator it_tune{ m_json_config.find( "autotune"s ) };
+    if( it_tune == m_json_config.cend() || !it_tune->is_object() ) { return tuning; }
+
+    json::const_iterator it_dev{ it_tune->find( device ) };
+    if( it_dev == it_tune->cend() || !it_dev->is_object() ) { return tuning; }
+
+    json::const_iterator it_val{ it_dev->find( "intensity"s ) };
+    if( it_val != it_dev->cend() && it_val->is_number() )
+    {
+      tuning.intensity = it_val->get<double>();
+    }
+    it_val = it_dev->find( "worksize"s );
+    if( it_val != it_dev->cend() && it_val->is_number_unsigned() )
+    {
+      tuning.work_size = it_val->get<uint32_t>();
+    }
+    it_val = it_dev->find( "threads"s );
+    if( it_val != it_dev->cend() && it_val->is_number_unsigned() )
+    {
+      tuning.threads = it_val->get<uint32_t>();
+    }
+
+    return tuning;
+  }
+
+  auto setTuning( std::string const& device, tuning_t const& tuning ) -> void
+  {
+    json entry( json::value_t::object );
+    if( tuning.intensity > 0. ) { entry["intensity"s] = tuning.intensity; }
+    if( tuning.work_size > 0u ) { entry["worksize"s] = tuning.work_size; }
+    if( tuning.threads > 0u ) { entry["threads"s] = tuning.threads; }
+
+    m_json_config["autotune"s][device] = entry;
+  }
+
+  auto saveTuning() -> bool
+  {
+    std::string config;
+    {
+      std::ifstream in( "nabiki.json", std::ios::binary );
+      if( !in ) { return false; }
+      config.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+    }
+
+    std::string_view const nl{ config.find( "\r\n"s ) != std::string::npos ? "\r\n"sv : "\n"sv };
+
+    // out with the old block, markers and all
+    size_t begin{ config.find( TUNING_BEGIN ) };
+    if( begin != std::string::npos )
+    {
+      size_t end{ config.find( TUNING_END, begin ) };
+      if( end == std::string::npos ) { return false; }
+      end = config.find( '\n', end );
+      // along with the blank line after it
+      if( end != std::string::npos && config.compare( end + 1u, nl.size(), nl ) == 0 )
+      {
+        end += nl.size();
+      }
+      config.erase( begin, end == std::string::npos ? std::string::npos : end + 1u - begin );
+    }
+
+    // and in with the new, first thing in the top-level object; a comma
+    // only if something follows it
+    size_t const open{ config.find( '{' ) };
+    if( open == std::string::npos ) { return false; }
+    bool const last{ m_json_config.size() <= 1u };
+
+    std::stringstream ss_out;
+    ss_out << TUNING_BEGIN << nl
+           << "  // \"autotune\" holds what --autotune picked for each device, by name,"sv << nl
+           << "  // and takes precedence over the settings below. It's rewritten on"sv << nl
+           << "  // every run; delete it to go back to the hand-picked values."sv << nl
+           << "  \"autotune\" : "sv;
+    std::string block{ m_json_config["autotune"s].dump( 2 ) };
+    for( size_t pos{ block.find( '\n' ) }; pos != std::string::npos; pos = block.find( '\n', pos + nl.size() + 2u ) )
+    {
+      block.replace( pos, 1u, std::string( nl ) + "  "s );
+    }
+    ss_out << block << (last ? ""sv : ","sv) << nl
+           << TUNING_END << nl << nl;
+
+    size_t const insert{ config.find( '\n', open ) };
+    config.insert( insert == std::string::npos ? config.size() : insert + 1u, ss_out.str() );
+
+    std::ofstream out( "nabiki.json", std::ios::binary | std::ios::trunc );
+    out << config;
+    return static_cast<bool>( out );
+  }
+
   auto setTokenName( std::string_view const token ) -> void
   {
     m_token_name = token;
@@ -824,6 +1045,26 @@ namespace MinerState
       } );
   }
 
+  auto setBenchmark( uint32_t const& seconds ) -> void
+  {
+    m_benchmark = seconds;
+  }
+
+  auto getBenchmark() -> uint32_t const&
+  {
+    return m_benchmark;
+  }
+
+  auto setAutotune( uint32_t const& max_launch_ms ) -> void
+  {
+    m_autotune = max_launch_ms;
+  }
+
+  auto getAutotune() -> uint32_t const&
+  {
+    return m_autotune;
+  }
+
   auto isDebug() -> bool const&
   {
     return m_debug;
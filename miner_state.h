@@ -32,6 +32,20 @@
 #include <string_view>
 #include <vector>
 #include <chrono>
+#include <memory>
+
+// Everything a solver needs to hash, as of one moment. Published whole
+// and never changed afterwards, so whatever a solver holds is always one
+// consistent piece of work. The epoch moves on with each new message; a
+// new target alone republishes the same epoch.
+struct job_t
+{
+  uint64_t epoch;
+  message_t message;
+  midstate_t midstate;
+  BigUnsigned target;
+  uint64_t target_num;
+};
 
 // this really needs to be broken down
 namespace MinerState
@@ -42,15 +56,21 @@ namespace MinerState
 
   auto Init() -> void;
 
+  // leases the next `threads` nonces; hash counts are Stats' business
   auto getIncSearchSpace( uint64_t const& threads ) -> uint64_t const;
+  // starts a new round, for the UI's per-round hash count and timer
   auto resetCounter() -> void;
-  auto getPrintableHashCount() -> uint64_t const;
   auto getRoundStartTime() -> time_point<steady_clock> const&;
 
-  template<typename T>
-  auto pushSolution( T const sols ) -> void;
-  auto getSolution() -> string;
-  auto getAllSolutions() -> std::vector<std::string>;
+  // Queues nonces found for the given job without blocking or allocating;
+  // safe from any number of solver threads. Nonces that don't fit are
+  // counted and reported by the next drain.
+  auto pushSolutions( uint64_t const* nonces, size_t const& count, uint64_t const& job ) noexcept -> void;
+  // Empties the queue, so only one thread - the network thread, or the
+  // benchmark in its place - may call it.
+  auto drainSolutions( std::vector<found_t>& found ) -> void;
+  // the hex solution a pool expects for the given nonce
+  auto formatSolution( uint64_t const& nonce ) -> string;
   auto incSolCount( uint64_t const& count = 1 ) -> void;
   auto getSolCount() -> uint64_t const;
 
@@ -60,15 +80,19 @@ namespace MinerState
   auto getMaximumTarget() -> BigUnsigned const&;
 
   auto getPrefix() -> string const;
-  auto getOldPrefix() -> string const;
   auto setChallenge( string_view const challenge ) -> void;
   auto getChallenge() -> string const;
   auto getPreviousChallenge() -> string const;
   auto setPoolAddress( string_view const address ) -> void;
   auto getPoolAddress() -> string const;
   auto getMessage() -> message_t const;
+  // builds and publishes a new job from the current message and target
   auto setMidstate() -> void;
-  auto getMidstate() -> state_t const;
+  // the current job, epoch 0 and all zeroes until there's a challenge
+  // and a pool address; one atomic load, no locks
+  auto getJob() -> std::shared_ptr<job_t const>;
+  // the job with the given epoch while it's among the last few, else null
+  auto getRecentJob( uint64_t const& epoch ) -> std::shared_ptr<job_t const>;
 
   auto setAddress( string_view const address ) -> void;
   auto getAddress() -> string const;
@@ -84,6 +108,25 @@ namespace MinerState
   auto getCudaDevices() -> device_list_t const&;
   auto getClDevices() -> device_map_t const&;
   auto getCpuThreads() -> uint32_t const&;
+  auto getCpuKernel() -> string_view;
+  auto getCpuJit() -> bool const&;
+  auto getCpuIntensity() -> double const&;
+  auto getCpuAffinity() -> string_view;
+  auto getCpuAffinityList() -> std::vector<uint32_t> const&;
+  auto getCpuReserve() -> uint32_t const&;
+  // off during --autotune, whatever the setting
+  auto getCpuIdle() -> bool const;
+  auto getCpuIdlePressure() -> double const&;
+
+  // how long each GPU launch should take, in ms, or 0 to launch a fixed
+  // 2^intensity work items every time
+  auto getLaunchTarget() -> double const;
+
+  // the "autotune" entry for the named device, all zeroes if there's none
+  auto getTuning( string const& device ) -> tuning_t const;
+  auto setTuning( string const& device, tuning_t const& tuning ) -> void;
+  // rewrites the "autotune" block of nabiki.json, leaving the rest alone
+  auto saveTuning() -> bool;
 
   auto setTokenName( string_view const token ) -> void;
 
@@ -97,6 +140,16 @@ namespace MinerState
 
   auto waitUntilReady() -> void;
   auto isDebug() -> bool const&;
+
+  // seconds to run an offline benchmark for, or 0 to mine normally; set
+  // before Init() to override "benchmark" in the configuration
+  auto setBenchmark( uint32_t const& seconds ) -> void;
+  auto getBenchmark() -> uint32_t const&;
+
+  // the longest launch, in ms, --autotune may settle on, or 0 to mine
+  // normally; set before Init()
+  auto setAutotune( uint32_t const& max_launch_ms ) -> void;
+  auto getAutotune() -> uint32_t const&;
 }
 
 #endif // !_MINER_STATE_H_
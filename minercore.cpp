@@ -30,16 +30,29 @@
 #include "cpusolver.h"
 #include "cudasolver.h"
 #include "clsolver.h"
+#include "placement.h"
+#include "autotune.h"
+#include "sharedwork.h"
 #include "telemetry.h"
+#include "stats.h"
 #include "ui.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
+#include <iostream>
+#include <iomanip>
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using namespace std::literals::string_literals;
 using namespace std::literals::string_view_literals;
@@ -52,8 +65,17 @@ namespace
   static uint_fast16_t m_solvers_cuda{ 0u };
   static uint_fast16_t m_solvers_cpu{ 0u };
   static uint_fast16_t m_solvers_cl{ 0u };
+  // the one CPUSolver runs this many threads; for the start message only
+  static uint_fast16_t m_cpu_threads{ 0u };
   static steady_clock::time_point m_launch_time;
 
+  // a benchmark or --autotune, running instead of the pool
+  static std::thread m_offline_thread;
+  static std::mutex m_offline_mutex;
+  static std::condition_variable m_offline_cv;
+  static bool m_offline_stop{ false };
+  static std::string m_offline_report;
+
   static auto printStartMessage() -> void
   {
     std::stringstream ss_out;
@@ -78,7 +100,7 @@ namespace
     }
     if( m_solvers_cpu > 0u )
     {
-      ss_out << m_solvers_cpu << " CPU core"sv << (m_solvers_cpu > 1 ? "s"sv : ""sv);
+      ss_out << m_cpu_threads << " CPU core"sv << (m_cpu_threads > 1 ? "s"sv : ""sv);
     }
 
     ss_out << "."sv;
@@ -86,21 +108,63 @@ namespace
     Log::pushLog( ss_out.str() );
   }
 
-  static auto createMiners() -> void
+  // PCI addresses as sysfs names them
+  static auto formatPciBusId( uint32_t const& domain, uint32_t const& bus,
+                              uint32_t const& device, uint32_t const& function ) -> std::string
   {
-    MinerState::waitUntilReady();
+    char bus_id[16];
+    std::snprintf( bus_id, sizeof( bus_id ), "%04x:%02x:%02x.%x", domain, bus, device, function );
+    return bus_id;
+  }
 
-    for( auto const&[ device, intensity ] : MinerState::getCudaDevices() )
+  static auto cudaPciBusId( CUdevice const& device ) -> std::string
+  {
+    Cuda cu{};
+    int32_t domain, bus, slot;
+    if( cu.DeviceGetAttribute( &domain, CU_DEVICE_ATTRIBUTE_PCI_DOMAIN_ID, device ) != CUDA_SUCCESS
+      || cu.DeviceGetAttribute( &bus, CU_DEVICE_ATTRIBUTE_PCI_BUS_ID, device ) != CUDA_SUCCESS
+      || cu.DeviceGetAttribute( &slot, CU_DEVICE_ATTRIBUTE_PCI_DEVICE_ID, device ) != CUDA_SUCCESS ) { return {}; }
+
+    return formatPciBusId( uint32_t( domain ), uint32_t( bus ), uint32_t( slot ), 0u );
+  }
+
+  // each vendor has its own query; whichever the platform answers wins
+  static auto clPciBusId( cl_device_id const& device ) -> std::string
+  {
+    Opencl cl{};
+
+#if defined CL_DEVICE_PCI_BUS_INFO_KHR
+    cl_device_pci_bus_info_khr info;
+    if( cl.GetDeviceInfo( device, CL_DEVICE_PCI_BUS_INFO_KHR, sizeof( info ), &info, nullptr ) == CL_SUCCESS )
+    {
+      return formatPciBusId( info.pci_domain, info.pci_bus, info.pci_device, info.pci_function );
+    }
+#endif // CL_DEVICE_PCI_BUS_INFO_KHR
+
+#if defined CL_DEVICE_TOPOLOGY_AMD
+    cl_device_topology_amd topology;
+    if( cl.GetDeviceInfo( device, CL_DEVICE_TOPOLOGY_AMD, sizeof( topology ), &topology, nullptr ) == CL_SUCCESS
+      && topology.raw.type == CL_DEVICE_TOPOLOGY_TYPE_PCIE_AMD )
     {
-      m_solvers.push_back( std::make_shared<CUDASolver>( device, intensity ) );
-      ++m_solvers_cuda;
+      return formatPciBusId( 0u, uint8_t( topology.pcie.bus ), uint8_t( topology.pcie.device ),
+                             uint8_t( topology.pcie.function ) );
     }
+#endif // CL_DEVICE_TOPOLOGY_AMD
 
-    for( m_solvers_cpu = 0; m_solvers_cpu < MinerState::getCpuThreads(); ++m_solvers_cpu )
+#if defined CL_DEVICE_PCI_BUS_ID_NV
+    cl_uint bus, slot;
+    if( cl.GetDeviceInfo( device, CL_DEVICE_PCI_BUS_ID_NV, sizeof( bus ), &bus, nullptr ) == CL_SUCCESS
+      && cl.GetDeviceInfo( device, CL_DEVICE_PCI_SLOT_ID_NV, sizeof( slot ), &slot, nullptr ) == CL_SUCCESS )
     {
-      m_solvers.push_back( std::make_shared<CPUSolver>() );
+      return formatPciBusId( 0u, bus, slot, 0u );
     }
+#endif // CL_DEVICE_PCI_BUS_ID_NV
+
+    return {};
+  }
 
+  static auto listClGpus( std::vector<Nabiki::Autotune::device_t>& gpus ) -> void
+  {
     Opencl cl{};
     if( !cl.Flush ) { return; }
 
@@ -140,13 +204,208 @@ namespace
 
         for( auto const&[ device, intensity ] : pDevices )
         {
-          m_solvers.push_back( std::make_shared<CLSolver>( devices[size_t(device)], intensity ) );
-          ++m_solvers_cl;
+          cl_device_id const id{ devices[size_t(device)] };
+          size_t max_work_size{ 0u };
+          cl.GetDeviceInfo( id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof( max_work_size ), &max_work_size, nullptr );
+
+          gpus.push_back( { Nabiki::MakeDeviceTelemetryObject( id )->getName(), DEVICE_OPENCL, intensity,
+                            static_cast<uint32_t>( max_work_size ), clPciBusId( id ),
+                            [id]( double const& intensity, uint32_t const& work_size ) -> std::shared_ptr<ISolver>
+                            { return std::make_shared<CLSolver>( id, intensity, work_size ); } } );
         }
         delete[] devices;
       }
     }
   }
+
+  // every GPU enabled in the configuration, CUDA first
+  static auto listGpus() -> std::vector<Nabiki::Autotune::device_t>
+  {
+    std::vector<Nabiki::Autotune::device_t> gpus;
+
+    for( auto const&[ device, intensity ] : MinerState::getCudaDevices() )
+    {
+      Cuda cu{};
+      CUdevice handle{ 0 };
+      cu.DeviceGet( &handle, device );
+
+      gpus.push_back( { Nabiki::MakeDeviceTelemetryObject( handle )->getName(), DEVICE_CUDA, intensity, 0u,
+                        cudaPciBusId( handle ),
+                        [device = device]( double const& intensity, uint32_t const& ) -> std::shared_ptr<ISolver>
+                        { return std::make_shared<CUDASolver>( device, intensity ); } } );
+    }
+
+    listClGpus( gpus );
+
+    return gpus;
+  }
+
+  // Stands in for the pool: a random challenge and pool address, and the
+  // configured custom difficulty or else the easiest one there is, so that
+  // shares turn up often enough to count.
+  static auto setBenchmarkJob() -> void
+  {
+    std::mt19937_64 gen{ std::random_device{}() };
+    auto const randomHex = [&gen]( size_t const bytes ) -> std::string
+    {
+      std::stringstream ss_out;
+      ss_out << "0x"sv << std::hex << std::setfill( '0' );
+      for( size_t i{ 0u }; i < bytes; ++i )
+      {
+        ss_out << std::setw( 2 ) << ( gen() & 0xffu );
+      }
+      return ss_out.str();
+    };
+
+    MinerState::setPoolAddress( randomHex( 20u ) );
+    MinerState::setChallenge( randomHex( 32u ) );
+    if( !MinerState::getCustomDiff() )
+    {
+      MinerState::setDiff( 1u );
+    }
+  }
+
+  // Samples every solver once a second past a warm-up, and counts the
+  // shares the solvers queue up, until the configured time has run or the
+  // miner is stopped. Stops the miner itself on a clean finish.
+  static auto runBenchmark() -> void
+  {
+    seconds const length{ MinerState::getBenchmark() };
+    auto const warmup{ std::min( length / 4, seconds{ 5 } ) };
+    auto const start{ steady_clock::now() };
+
+    std::vector<double> hashrates( m_solvers.size() );
+    uint64_t samples{ 0u };
+    uint64_t shares{ 0u };
+    std::vector<found_t> found;
+
+    Log::pushLog( "Benchmarking for "s + std::to_string( length.count() ) + " seconds."s );
+
+    std::unique_lock<std::mutex> lock{ m_offline_mutex };
+    bool interrupted{ false };
+    for( auto next{ start + 1s }; next <= start + length; next += 1s )
+    {
+      if( m_offline_cv.wait_until( lock, next, []{ return m_offline_stop; } ) )
+      {
+        interrupted = true;
+        break;
+      }
+
+      found.clear();
+      MinerState::drainSolutions( found );
+      shares += found.size();
+
+      if( next - start <= warmup ) { continue; }
+
+      for( size_t i{ 0u }; i < m_solvers.size(); ++i )
+      {
+        hashrates[i] += m_solvers[i]->getHashrate();
+      }
+      ++samples;
+    }
+
+    auto const elapsed{ duration<double>( steady_clock::now() - start ).count() };
+
+    std::stringstream ss_out;
+    ss_out << std::fixed << std::setprecision( 2 )
+           << "\nBenchmark results ("sv << elapsed << " s"sv
+           << (interrupted ? ", interrupted"sv : ""sv) << ")\n"sv;
+
+    double total{ 0. };
+    for( size_t i{ 0u }; i < m_solvers.size(); ++i )
+    {
+      double const mean{ samples > 0u ? hashrates[i] / samples : 0. };
+      total += mean;
+      ss_out << "  #"sv << i << ' ' << std::left << std::setw( 32 ) << m_solvers[i]->getName() << std::right
+             << std::setw( 12 ) << mean << " MH/s"sv
+             << std::setw( 10 ) << m_solvers[i]->getLaunchTime() << " ms/launch\n"sv;
+    }
+    // each hash is a share with odds target / 2^256, and the top 64 bits of
+    // the target are all that matter at these rates
+    double const expected{ total * 1e6 * MinerState::getTargetNum() / 18446744073709551616. };
+    ss_out << "  Total"sv << std::setw( 41 ) << total << " MH/s\n"sv
+           << "  Shares: "sv << shares
+           << " ("sv << std::setprecision( 4 ) << shares / elapsed << "/s, "sv
+           << expected << "/s expected at difficulty "sv << MinerState::getDiff() << ")\n"sv;
+    m_offline_report = ss_out.str();
+
+    if( !interrupted )
+    {
+      lock.unlock();
+      MinerCore::stop();
+    }
+  }
+
+  // Tunes every configured device in turn, with the CPU threads as
+  // configured at most, then stops the miner on a clean finish.
+  static auto runAutotune() -> void
+  {
+    auto const gpus{ listGpus() };
+
+    std::vector<std::string> bus_ids;
+    for( auto const& gpu : gpus )
+    {
+      bus_ids.emplace_back( gpu.pci_bus_id );
+    }
+
+    std::shared_ptr<CPUSolver> cpu;
+    auto const cpus{ Nabiki::Placement::planCpuThreads( MinerState::getCpuThreads(), bus_ids ) };
+    if( !cpus.empty() )
+    {
+      cpu = std::make_shared<CPUSolver>( MinerState::getCpuIntensity(), cpus );
+    }
+
+    Log::pushLog( "Autotuning "s + std::to_string( gpus.size() ) + " GPU"s + (gpus.size() == 1u ? ""s : "s"s) +
+                  (cpu ? " and the CPU"s : ""s) + " - this will take a while."s );
+
+    std::string report{ Nabiki::Autotune::Run( gpus, cpu, Nabiki::MakeDeviceTelemetryObject( nullptr )->getName(),
+                                               MinerState::getAutotune() ) };
+
+    cond_lock lock{ m_offline_mutex };
+    if( m_offline_stop ) { return; }
+
+    m_offline_report = std::move( report );
+    lock.unlock();
+    MinerCore::stop();
+  }
+
+  static auto createMiners() -> void
+  {
+    MinerState::waitUntilReady();
+
+    // anything --autotune has picked goes over the hand-set values
+    std::vector<std::string> bus_ids;
+    for( auto const& gpu : listGpus() )
+    {
+      auto const tuning{ MinerState::getTuning( gpu.name ) };
+      m_solvers.push_back( gpu.make( tuning.intensity > 0. ? tuning.intensity : gpu.intensity, tuning.work_size ) );
+      bus_ids.emplace_back( gpu.pci_bus_id );
+      if( gpu.type == DEVICE_CUDA )
+      {
+        ++m_solvers_cuda;
+      }
+      else
+      {
+        ++m_solvers_cl;
+      }
+    }
+
+    uint32_t threads{ MinerState::getCpuThreads() };
+    if( threads > 0u )
+    {
+      auto const tuning{ MinerState::getTuning( Nabiki::MakeDeviceTelemetryObject( nullptr )->getName() ) };
+      threads = tuning.threads > 0u ? tuning.threads : threads;
+    }
+
+    // placed last, once it's known which GPUs' host threads to leave room for
+    auto const cpus{ Nabiki::Placement::planCpuThreads( threads, bus_ids ) };
+    if( !cpus.empty() )
+    {
+      m_solvers.push_back( std::make_shared<CPUSolver>( MinerState::getCpuIntensity(), cpus ) );
+      m_solvers_cpu = 1u;
+      m_cpu_threads = static_cast<uint_fast16_t>( cpus.size() );
+    }
+  }
 }
 
 namespace MinerCore
@@ -167,19 +426,55 @@ namespace MinerCore
     }
   }
 
-  auto run() -> int32_t
+  auto run( int32_t const argc, char const* const* argv ) -> int32_t
   {
     m_launch_time = steady_clock::now();
 
+    for( int32_t i{ 1 }; i < argc; ++i )
+    {
+      if( std::strcmp( argv[i], "--benchmark" ) == 0 )
+      {
+        uint32_t seconds{ 60u };
+        if( i + 1 < argc && std::strtoul( argv[i + 1], nullptr, 10 ) > 0u )
+        {
+          seconds = static_cast<uint32_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+        }
+        MinerState::setBenchmark( seconds );
+      }
+      else if( std::strcmp( argv[i], "--autotune" ) == 0 )
+      {
+        uint32_t max_launch_ms{ 100u };
+        if( i + 1 < argc && std::strtoul( argv[i + 1], nullptr, 10 ) > 0u )
+        {
+          max_launch_ms = static_cast<uint32_t>( std::strtoul( argv[++i], nullptr, 10 ) );
+        }
+        MinerState::setAutotune( max_launch_ms );
+      }
+    }
+
     InitBaseState();
 
     UI::Init();
 
     MinerState::Init();
 
-    Commo::Init();
+    if( MinerState::getAutotune() > 0u || MinerState::getBenchmark() > 0u )
+    {
+      setBenchmarkJob();
+    }
+    else
+    {
+      Commo::Init();
+    }
 
-    createMiners();
+    if( MinerState::getAutotune() > 0u )
+    {
+      m_offline_thread = std::thread{ runAutotune };
+    }
+    else
+    {
+      createMiners();
+    }
 
     std::thread uiThread{ UI::Run };
 
@@ -188,13 +483,29 @@ namespace MinerCore
       solver->startFinding();
     }
 
-    printStartMessage();
+    if( MinerState::getAutotune() == 0u )
+    {
+      printStartMessage();
+    }
+
+    Stats::Init();
 
     Telemetry::Init();
 
+    if( MinerState::getBenchmark() > 0u && MinerState::getAutotune() == 0u )
+    {
+      m_offline_thread = std::thread{ runBenchmark };
+    }
+
     if( uiThread.joinable() )
       uiThread.join();
 
+    if( m_offline_thread.joinable() )
+    {
+      m_offline_thread.join();
+      std::cout << m_offline_report << std::flush;
+    }
+
     CleanupBaseState();
 
     return 0;
@@ -202,6 +513,15 @@ namespace MinerCore
 
   auto stop() -> void
   {
+    {
+      guard lock{ m_offline_mutex };
+      m_offline_stop = true;
+    }
+    m_offline_cv.notify_all();
+    Nabiki::Autotune::Stop();
+
+    Stats::Cleanup();
+
     UI::Stop();
 
     for( auto const& solver : m_solvers )
@@ -209,11 +529,13 @@ namespace MinerCore
       solver->stopFinding();
     }
 
-    m_solvers_cuda = m_solvers_cpu = 0u;
+    m_solvers_cuda = m_solvers_cpu = m_cpu_threads = 0u;
 
     Telemetry::Cleanup();
 
     Commo::Cleanup();
+
+    Nabiki::SharedWork::Leave();
   }
 
   auto getHashrates() -> std::vector<double> const
@@ -226,6 +548,16 @@ namespace MinerCore
     return temp;
   }
 
+  auto getSwitchLatency() -> double const
+  {
+    double slowest{ 0. };
+    for( auto const& solver : m_solvers )
+    {
+      slowest = std::max( slowest, solver->getSwitchTime() );
+    }
+    return slowest;
+  }
+
   auto getDevice( size_t devIndex ) -> ISolver*
   {
     return m_solvers[devIndex].get();
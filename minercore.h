@@ -49,10 +49,14 @@ namespace MinerCore
   auto updateTarget() -> void;
   auto updateMessage() -> void;
 
-  auto run() -> int32_t;
+  // argv may carry --benchmark [seconds] for an offline run against a
+  // synthetic job; see "benchmark" in nabiki.json
+  auto run( int32_t const argc = 0, char const* const* argv = nullptr ) -> int32_t;
   auto stop() -> void;
 
   auto getHashrates() -> std::vector<double> const;
+  // from the last new message to every device hashing it, in ms
+  auto getSwitchLatency() -> double const;
   auto getDevice( size_t devIndex ) -> ISolver*;
   auto getDeviceReferences() -> std::vector<std::shared_ptr<ISolver>> const;
 
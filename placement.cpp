@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "placement.h"
+#include "platforms.h"
+#include "miner_state.h"
+#include "log.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+  struct core_t
+  {
+    uint32_t node;
+    std::vector<uint32_t> cpus; // SMT siblings, lowest first
+    bool reserved;
+  };
+
+  // groups the logical processors into physical cores, in package order
+  static auto groupCores( std::vector<cpu_info_t> const& cpus ) -> std::vector<core_t>
+  {
+    std::map<std::pair<uint32_t, uint32_t>, core_t> by_id;
+    for( auto const& cpu : cpus )
+    {
+      auto& core{ by_id[{ cpu.package, cpu.core }] };
+      core.node = cpu.node;
+      core.cpus.emplace_back( cpu.id );
+    }
+
+    std::vector<core_t> cores;
+    for( auto& [ id, core ] : by_id )
+    {
+      std::sort( core.cpus.begin(), core.cpus.end() );
+      cores.emplace_back( std::move( core ) );
+    }
+    return cores;
+  }
+
+  // holds back `count` cores on `node` - or on any node, once that one
+  // runs out - but never the last core left for mining
+  static auto reserveCores( std::vector<core_t>& cores, uint32_t const& node, uint32_t count ) -> uint32_t
+  {
+    uint32_t reserved{ 0u };
+    for( bool const any_node : { false, true } )
+    {
+      for( auto& core : cores )
+      {
+        if( count == 0u ) { return reserved; }
+        if( core.reserved || (!any_node && core.node != node) ) { continue; }
+
+        if( std::count_if( cores.begin(), cores.end(),
+                           []( core_t const& c ) { return !c.reserved; } ) <= 1 ) { return reserved; }
+
+        core.reserved = true;
+        --count;
+        ++reserved;
+      }
+    }
+    return reserved;
+  }
+}
+
+namespace Nabiki::Placement
+{
+  auto planCpuThreads( uint32_t const& threads, std::vector<std::string> const& gpus ) -> std::vector<int32_t>
+  {
+    std::vector<int32_t> plan( threads, -1 );
+
+    auto const mode{ MinerState::getCpuAffinity() };
+    if( threads == 0u || mode == "none"sv ) { return plan; }
+
+    std::vector<uint32_t> slots;
+    uint32_t reserved{ 0u };
+    if( mode == "list"sv )
+    {
+      slots = MinerState::getCpuAffinityList();
+    }
+    else
+    {
+      if( mode != "auto"sv && mode != "compact"sv )
+      {
+        Log::pushLog( "Unknown CPU affinity \""s + std::string( mode ) + "\"; using \"auto\" instead."s );
+      }
+
+      auto cores{ groupCores( GetCpuTopology() ) };
+
+      // a GPU that can't be placed gets nothing held back, rather than
+      // cores on a node it may well not be on
+      uint32_t unplaced{ 0u };
+      for( auto const& bus_id : gpus )
+      {
+        int32_t const node{ GetPciNode( bus_id ) };
+        if( node < 0 )
+        {
+          ++unplaced;
+          continue;
+        }
+        reserved += reserveCores( cores, static_cast<uint32_t>( node ), MinerState::getCpuReserve() );
+      }
+      if( unplaced > 0u && MinerState::getCpuReserve() > 0u )
+      {
+        Log::pushLog( "Couldn't find the NUMA node of "s + std::to_string( unplaced ) + " GPU"s +
+                      (unplaced > 1u ? "s"s : ""s) + "; no cores kept for "s + (unplaced > 1u ? "them."s : "it."s) );
+      }
+
+      if( mode == "compact"sv )
+      {
+        for( auto const& core : cores )
+        {
+          if( core.reserved ) { continue; }
+          slots.insert( slots.end(), core.cpus.begin(), core.cpus.end() );
+        }
+      }
+      else
+      {
+        // every physical core gets a thread before any SMT sibling does
+        for( size_t sibling{ 0u }, added{ 1u }; added > 0u; ++sibling )
+        {
+          added = 0u;
+          for( auto const& core : cores )
+          {
+            if( core.reserved || sibling >= core.cpus.size() ) { continue; }
+            slots.emplace_back( core.cpus[sibling] );
+            ++added;
+          }
+        }
+      }
+    }
+
+    if( slots.empty() )
+    {
+      Log::pushLog( "No CPU topology available; CPU threads will not be pinned."s );
+      return plan;
+    }
+
+    std::stringstream ss_out;
+    ss_out << "Pinning CPU threads to logical CPUs"sv;
+    for( size_t i{ 0u }; i < plan.size(); ++i )
+    {
+      plan[i] = static_cast<int32_t>( slots[i % slots.size()] );
+      ss_out << (i > 0u ? ", "sv : " "sv) << plan[i];
+    }
+    if( reserved > 0u )
+    {
+      ss_out << " (" << reserved << " core"sv << (reserved > 1u ? "s"sv : ""sv) << " kept for GPUs)"sv;
+    }
+    ss_out << "."sv;
+    Log::pushLog( ss_out.str() );
+
+    if( threads > slots.size() )
+    {
+      Log::pushLog( "There are more CPU threads than free logical CPUs; some will share."s );
+    }
+
+    return plan;
+  }
+}
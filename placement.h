@@ -0,0 +1,41 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _PLACEMENT_H_
+#define _PLACEMENT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nabiki::Placement
+{
+  // Decides which logical processor each of `threads` CPU mining threads
+  // is pinned to, following the "cpu_affinity" setting. Physical cores
+  // near each GPU in `gpus` (by PCI address, empty if unknown) are held
+  // back per "cpu_reserve" for its host thread. An entry of -1 leaves
+  // that thread unpinned.
+  auto planCpuThreads( uint32_t const& threads, std::vector<std::string> const& gpus ) -> std::vector<int32_t>;
+}
+
+#endif // !_PLACEMENT_H_
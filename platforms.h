@@ -25,12 +25,65 @@
 #define _PLATFORMS_H_
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 extern bool UseSimpleUI;
 
+// instruction set extensions usable by this process - that is, supported
+// by the CPU _and_ with any extended register state enabled by the OS
+enum cpu_feature_t : uint32_t
+{
+  CPU_SSE2    = 1u << 0,
+  CPU_AVX2    = 1u << 1,
+  CPU_AVX512F = 1u << 2,
+  CPU_BMI2    = 1u << 3, // BMI1 and BMI2 both
+  CPU_NEON    = 1u << 4, // AArch64 Advanced SIMD
+  CPU_SHA3    = 1u << 5, // ARMv8.2 EOR3, RAX1, XAR and BCAX
+};
+
+// a logical processor this process is allowed to run on
+struct cpu_info_t
+{
+  uint32_t id;      // OS processor number, as used for affinity
+  uint32_t package; // physical socket
+  uint32_t core;    // physical core within the package
+  uint32_t node;    // NUMA node
+};
+
 auto InitBaseState() -> void;
 auto CleanupBaseState() -> void;
 auto GetRawCpuName() -> std::string;
+auto GetCpuFeatures() -> uint32_t;
+auto GetCpuTopology() -> std::vector<cpu_info_t>;
+// NUMA node of the PCI device at `bus_id` ("dddd:bb:dd.f"); 0 if the
+// system isn't NUMA, or negative if the device can't be found
+auto GetPciNode( std::string const& bus_id ) -> int32_t;
+// binds the calling thread to a single logical processor
+auto SetThreadAffinity( uint32_t const& cpu ) -> bool;
+// drops the calling thread to the lowest scheduling priority available,
+// so it only runs on otherwise idle CPUs
+auto SetThreadIdlePriority() -> bool;
+// average number of busy logical processors since the previous call, or
+// negative if unknown (as it always is on the first call)
+auto GetSystemLoad() -> double;
+// percentage of the last 10 seconds in which some runnable task was kept
+// waiting for a CPU, or negative if the OS doesn't report it
+auto GetCpuPressure() -> double;
+// page-aligned memory for generated code: allocated writable, then made
+// executable (and read-only) once the code is in place
+auto AllocExecutable( size_t const& size ) -> void*;
+auto ProtectExecutable( void* code, size_t const& size ) -> bool;
+auto FreeExecutable( void* code, size_t const& size ) -> void;
+// maps `size` bytes of memory shared under `name` with other processes on
+// this host, creating it zero-filled if none has yet - `created` says
+// which; null on failure
+auto MapSharedMemory( std::string const& name, size_t const& size, bool& created ) -> void*;
+auto UnmapSharedMemory( void* memory, size_t const& size ) -> void;
+// takes the name away, so the next process to map it starts afresh;
+// whoever has it mapped keeps it
+auto RemoveSharedMemory( std::string const& name ) -> void;
 
 #if defined _MSC_VER
 #  include <intrin.h>
@@ -39,9 +92,19 @@ auto GetRawCpuName() -> std::string;
 #  define bswap64 _byteswap_uint64
 
 #else // _MSC_VER
-#  include <x86intrin.h>
+#  if defined __x86_64__ || defined __i386__
+#    include <x86intrin.h>
+
+#    define rotl64 __rolq
+
+#  else // __x86_64__
+// GCC and clang both reduce this to a single rotate
+static inline auto rotl64( uint64_t const x, int32_t const n ) -> uint64_t
+{
+  return x << (n & 63) | x >> (-n & 63);
+}
 
-#  define rotl64 __rolq
+#  endif // __x86_64__
 #  define bswap64 __builtin_bswap64
 
 #endif // _MSC_VER
@@ -25,14 +25,35 @@
 #include "minercore.h"
 #include "log.h"
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <array>
 #include <thread>
 #include <cstdint>
+#include <cstdlib>
+#include <cerrno>
 #include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
 #include <signal.h>
 #include <termios.h>
-#include <cpuid.h>
+#if defined __x86_64__ || defined __i386__
+#  include <cpuid.h>
+#elif defined __aarch64__
+#  include <sys/auxv.h>
+#  include <asm/hwcap.h>
+#endif // __aarch64__
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 using namespace std::literals;
 
@@ -55,6 +76,35 @@ namespace
     MinerCore::stop();
     return;
   }
+
+  // reads the first integer in a sysfs attribute, or `fallback`
+  auto ReadSysfsInt( std::string const& path, int64_t const& fallback ) -> int64_t
+  {
+    std::ifstream in{ path };
+    int64_t value;
+    if( in >> value ) { return value; }
+    return fallback;
+  }
+
+  // lists the entries of a sysfs directory starting with `prefix`
+  auto ListSysfsDir( std::string const& path, std::string_view const prefix ) -> std::vector<std::string>
+  {
+    std::vector<std::string> entries;
+    DIR* dir{ opendir( path.c_str() ) };
+    if( !dir ) { return entries; }
+
+    while( dirent const* entry{ readdir( dir ) } )
+    {
+      if( std::string_view{ entry->d_name }.substr( 0u, prefix.length() ) == prefix )
+      {
+        entries.emplace_back( entry->d_name );
+      }
+    }
+    closedir( dir );
+
+    std::sort( entries.begin(), entries.end() );
+    return entries;
+  }
 }
 
 auto InitBaseState() -> void
@@ -93,6 +143,7 @@ auto CleanupBaseState() -> void
     sig_handler.join();
 }
 
+#if defined __x86_64__ || defined __i386__
 auto GetRawCpuName() -> std::string
 {
   std::array<uint32_t, 4> ret;
@@ -112,3 +163,242 @@ auto GetRawCpuName() -> std::string
   }
   return out;
 }
+
+auto GetCpuFeatures() -> uint32_t
+{
+  uint32_t eax, ebx, ecx, edx, features{ 0u };
+
+  if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) { return features; }
+
+  if( edx & bit_SSE2 ) { features |= CPU_SSE2; }
+
+  // the YMM/ZMM state has to be enabled by the OS, not just present
+  uint64_t xcr0{ 0u };
+  if( ecx & bit_OSXSAVE )
+  {
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__( "xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0) );
+    xcr0 = uint64_t( xcr0_hi ) << 32 | xcr0_lo;
+  }
+  bool const os_avx{ (xcr0 & 0x06u) == 0x06u };
+  bool const os_avx512{ (xcr0 & 0xe6u) == 0xe6u };
+
+  if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) ) { return features; }
+
+  if( (ebx & bit_BMI) && (ebx & bit_BMI2) ) { features |= CPU_BMI2; }
+  if( (ebx & bit_AVX2) && os_avx ) { features |= CPU_AVX2; }
+  if( (ebx & bit_AVX512F) && os_avx512 ) { features |= CPU_AVX512F; }
+
+  return features;
+}
+
+#else // __x86_64__
+auto GetRawCpuName() -> std::string
+{
+  // most ARM kernels don't report a model name at all
+  std::ifstream in{ "/proc/cpuinfo"s };
+  for( std::string line; std::getline( in, line ); )
+  {
+    if( line.compare( 0u, 10u, "model name"s ) != 0 ) { continue; }
+
+    auto const start{ line.find_first_not_of( " \t:"s, 10u ) };
+    if( start != std::string::npos ) { return line.substr( start ); }
+  }
+#  if defined __aarch64__
+  return "AArch64 CPU"s;
+#  else
+  return "Unknown CPU"s;
+#  endif
+}
+
+auto GetCpuFeatures() -> uint32_t
+{
+  uint32_t features{ 0u };
+#  if defined __aarch64__
+  unsigned long const hwcap{ getauxval( AT_HWCAP ) };
+  if( hwcap & HWCAP_ASIMD ) { features |= CPU_NEON; }
+#    if defined HWCAP_SHA3
+  if( hwcap & HWCAP_SHA3 ) { features |= CPU_SHA3; }
+#    endif // HWCAP_SHA3
+#  endif // __aarch64__
+  return features;
+}
+
+#endif // __x86_64__
+
+auto GetCpuTopology() -> std::vector<cpu_info_t>
+{
+  std::vector<cpu_info_t> cpus;
+
+  cpu_set_t allowed;
+  CPU_ZERO( &allowed );
+  if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) { return cpus; }
+
+  for( uint32_t cpu{ 0u }; cpu < CPU_SETSIZE; ++cpu )
+  {
+    if( !CPU_ISSET( cpu, &allowed ) ) { continue; }
+
+    std::string const path{ "/sys/devices/system/cpu/cpu"s + std::to_string( cpu ) };
+
+    uint32_t node{ 0u };
+    for( auto const& entry : ListSysfsDir( path, "node"sv ) )
+    {
+      node = static_cast<uint32_t>( std::stoul( entry.substr( 4u ) ) );
+    }
+
+    cpus.emplace_back( cpu_info_t{ cpu,
+                                   static_cast<uint32_t>( ReadSysfsInt( path + "/topology/physical_package_id"s, 0 ) ),
+                                   static_cast<uint32_t>( ReadSysfsInt( path + "/topology/core_id"s, cpu ) ),
+                                   node } );
+  }
+
+  return cpus;
+}
+
+auto GetPciNode( std::string const& bus_id ) -> int32_t
+{
+  if( bus_id.empty() ) { return -1; }
+
+  // numa_node is -1 when the device has no particular node, as on any
+  // single-node system; a device that isn't there has no numa_node at all
+  int64_t const node{ ReadSysfsInt( "/sys/bus/pci/devices/"s + bus_id + "/numa_node"s, -2 ) };
+  if( node == -2 ) { return -1; }
+  return node < 0 ? 0 : static_cast<int32_t>( node );
+}
+
+auto SetThreadAffinity( uint32_t const& cpu ) -> bool
+{
+  if( cpu >= CPU_SETSIZE ) { return false; }
+
+  cpu_set_t mask;
+  CPU_ZERO( &mask );
+  CPU_SET( cpu, &mask );
+
+  return pthread_setaffinity_np( pthread_self(), sizeof( mask ), &mask ) == 0;
+}
+
+auto SetThreadIdlePriority() -> bool
+{
+  // nice applies per thread on Linux; SCHED_IDLE goes further, yielding
+  // to any normal task at all, but isn't available everywhere
+  bool const niced{ setpriority( PRIO_PROCESS, static_cast<id_t>( syscall( SYS_gettid ) ), 19 ) == 0 };
+#if defined SCHED_IDLE
+  sched_param param{};
+  if( pthread_setschedparam( pthread_self(), SCHED_IDLE, &param ) == 0 ) { return true; }
+#endif // SCHED_IDLE
+  return niced;
+}
+
+auto GetSystemLoad() -> double
+{
+  // the load average lags by a minute or more, so measure busy time
+  // between calls instead, the same way win32 has to
+  static uint64_t last_idle{ 0u }, last_total{ 0u };
+
+  // "cpu  user nice system idle iowait irq softirq steal ..."
+  std::ifstream in{ "/proc/stat"s };
+  std::string label;
+  std::array<uint64_t, 8u> ticks;
+  if( !(in >> label) || label != "cpu"s ) { return -1; }
+  for( auto& tick : ticks )
+  {
+    if( !(in >> tick) ) { return -1; }
+  }
+
+  // iowait is time spent idle too
+  uint64_t const t_idle{ ticks[3] + ticks[4] };
+  uint64_t t_total{ 0u };
+  for( auto const& tick : ticks ) { t_total += tick; }
+  if( last_total == 0u || t_total == last_total )
+  {
+    last_idle = t_idle;
+    last_total = t_total;
+    return -1;
+  }
+
+  double const busy{ 1.0 - double( t_idle - last_idle ) / double( t_total - last_total ) };
+  last_idle = t_idle;
+  last_total = t_total;
+
+  return busy * std::max( std::thread::hardware_concurrency(), 1u );
+}
+
+auto GetCpuPressure() -> double
+{
+  // "some avg10=1.23 avg60=... avg300=... total=..."
+  std::ifstream in{ "/proc/pressure/cpu"s };
+  std::string kind, avg10;
+  if( !(in >> kind >> avg10) || kind != "some"s || avg10.substr( 0u, 6u ) != "avg10="s ) { return -1; }
+
+  return std::strtod( avg10.c_str() + 6u, nullptr );
+}
+
+auto AllocExecutable( size_t const& size ) -> void*
+{
+  void* const code{ mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) };
+  return code == MAP_FAILED ? nullptr : code;
+}
+
+auto ProtectExecutable( void* code, size_t const& size ) -> bool
+{
+  // fails where the system forbids executable anonymous memory outright
+  return mprotect( code, size, PROT_READ | PROT_EXEC ) == 0;
+}
+
+auto FreeExecutable( void* code, size_t const& size ) -> void
+{
+  munmap( code, size );
+}
+
+auto MapSharedMemory( std::string const& name, size_t const& size, bool& created ) -> void*
+{
+  std::string const path{ "/"s + name };
+
+  created = true;
+  int fd{ shm_open( path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 ) };
+  if( fd < 0 && errno == EEXIST )
+  {
+    created = false;
+    fd = shm_open( path.c_str(), O_RDWR, 0600 );
+  }
+  if( fd < 0 ) { return nullptr; }
+
+  if( created )
+  {
+    if( ftruncate( fd, static_cast<off_t>( size ) ) != 0 )
+    {
+      close( fd );
+      shm_unlink( path.c_str() );
+      return nullptr;
+    }
+  }
+  else
+  {
+    // the creator may not have sized it yet; touching it before then
+    // would fault
+    struct stat info{};
+    for( uint_fast8_t tries{ 0u }; fstat( fd, &info ) == 0 && static_cast<size_t>( info.st_size ) < size; ++tries )
+    {
+      if( tries == 100u )
+      {
+        close( fd );
+        return nullptr;
+      }
+      std::this_thread::sleep_for( 10ms );
+    }
+  }
+
+  void* const memory{ mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) };
+  close( fd );
+  return memory == MAP_FAILED ? nullptr : memory;
+}
+
+auto UnmapSharedMemory( void* memory, size_t const& size ) -> void
+{
+  munmap( memory, size );
+}
+
+auto RemoveSharedMemory( std::string const& name ) -> void
+{
+  shm_unlink( ("/"s + name).c_str() );
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sharedwork.h"
+#include "platforms.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <random>
+#include <thread>
+#include <type_traits>
+
+using namespace std::literals;
+using namespace std::chrono;
+
+namespace
+{
+  // "nabiki", and the layout's version in the low bytes
+  static uint64_t constexpr MAGIC{ 0x6e6162696b690001ull };
+  // a poll can block for the full 20 s cURL timeout, so a leader is only
+  // given up on once it's been quiet a good while longer
+  static int32_t constexpr LEADER_TIMEOUT_S{ 30 };
+  // challenge, pool address and diff, packed into whole words
+  static size_t constexpr JOB_WORDS{ 8u };
+
+  // Lives in the shared segment, so everything in it is a lock-free
+  // atomic; those are address-free, and work across processes as they do
+  // across threads. The creator's zero fill is every field's start value.
+  struct segment_t
+  {
+    std::atomic<uint64_t> magic;
+    std::atomic<uint64_t> solution[4];
+    std::atomic<uint32_t> members;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> next_nonce;
+
+    // the leader's token in the high half and the second it last renewed
+    // in the low, so both change with a single CAS
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> leader;
+    // a seqlock over `job`: odd while the leader is writing
+    std::atomic<uint64_t> job_seq;
+    std::atomic<uint64_t> job[JOB_WORDS];
+  };
+  static_assert( std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                 "shared memory needs lock-free atomics" );
+  static_assert( std::is_standard_layout_v<segment_t> );
+
+  static segment_t* m_segment{ nullptr };
+  static std::string m_name{};
+  static uint32_t m_token{ 0u };
+  static uint64_t m_job_seen{ 0u };
+
+  // wall-clock seconds, since other processes' steady clocks needn't agree
+  static auto now() -> uint32_t
+  {
+    return static_cast<uint32_t>( duration_cast<seconds>( system_clock::now().time_since_epoch() ).count() );
+  }
+}
+
+namespace Nabiki::SharedWork
+{
+  auto Join( std::string const& name, hash_t& solution ) -> bool
+  {
+    if( m_segment ) { return true; }
+
+    bool created;
+    void* const memory{ MapSharedMemory( name, sizeof( segment_t ), created ) };
+    if( !memory ) { return false; }
+
+    std::array<uint64_t, 4u> words;
+    if( created )
+    {
+      m_segment = new( memory ) segment_t{};
+      std::memcpy( words.data(), solution.data(), 32 );
+      for( size_t i{ 0u }; i < words.size(); ++i )
+      {
+        m_segment->solution[i].store( words[i], std::memory_order_relaxed );
+      }
+      m_segment->magic.store( MAGIC, std::memory_order_release );
+    }
+    else
+    {
+      // the creator fills it in straight after making it; anything else
+      // is another version's layout, or was abandoned half made
+      m_segment = std::launder( reinterpret_cast<segment_t*>( memory ) );
+      for( uint_fast8_t tries{ 0u }; m_segment->magic.load( std::memory_order_acquire ) != MAGIC; ++tries )
+      {
+        if( tries == 100u )
+        {
+          UnmapSharedMemory( memory, sizeof( segment_t ) );
+          m_segment = nullptr;
+          return false;
+        }
+        std::this_thread::sleep_for( 10ms );
+      }
+
+      for( size_t i{ 0u }; i < words.size(); ++i )
+      {
+        words[i] = m_segment->solution[i].load( std::memory_order_relaxed );
+      }
+      std::memcpy( solution.data(), words.data(), 32 );
+    }
+
+    m_segment->members.fetch_add( 1u, std::memory_order_acq_rel );
+    m_name = name;
+
+    std::mt19937 gen{ std::random_device{}() };
+    std::uniform_int_distribution<uint32_t> urInt{ 1u, UINT32_MAX };
+    m_token = urInt( gen );
+
+    return true;
+  }
+
+  auto Leave() -> void
+  {
+    if( !m_segment ) { return; }
+
+    uint64_t lease{ m_segment->leader.load( std::memory_order_acquire ) };
+    while( lease >> 32 == m_token &&
+           !m_segment->leader.compare_exchange_weak( lease, 0u, std::memory_order_acq_rel ) )
+    {}
+
+    // the last one out takes the name with it, so a fresh start gets a
+    // fresh segment; an instance starting at that very moment may end up
+    // on its own, which costs nothing but the sharing
+    if( m_segment->members.fetch_sub( 1u, std::memory_order_acq_rel ) == 1u )
+    {
+      RemoveSharedMemory( m_name );
+    }
+
+    UnmapSharedMemory( m_segment, sizeof( segment_t ) );
+    m_segment = nullptr;
+  }
+
+  auto IsJoined() -> bool
+  {
+    return m_segment != nullptr;
+  }
+
+  auto LeaseNonces( uint64_t const& count ) -> uint64_t
+  {
+    return m_segment->next_nonce.fetch_add( count, std::memory_order_acq_rel );
+  }
+
+  auto IsLeader() -> bool
+  {
+    uint32_t const second{ now() };
+    uint64_t lease{ m_segment->leader.load( std::memory_order_acquire ) };
+    for( ;; )
+    {
+      uint32_t const holder{ static_cast<uint32_t>( lease >> 32 ) };
+      uint32_t const renewed{ static_cast<uint32_t>( lease ) };
+
+      if( holder == m_token )
+      {
+        if( renewed == second ) { return true; }
+      }
+      else if( holder != 0u && static_cast<int32_t>( second - renewed ) < LEADER_TIMEOUT_S )
+      {
+        return false;
+      }
+
+      if( m_segment->leader.compare_exchange_weak( lease, uint64_t{ m_token } << 32 | second,
+                                                   std::memory_order_acq_rel ) )
+      {
+        return true;
+      }
+    }
+  }
+
+  auto PublishJob( pool_job_t const& job ) -> void
+  {
+    std::array<uint64_t, JOB_WORDS> words{};
+    std::memcpy( words.data(), job.challenge.data(), 32 );
+    std::memcpy( &words[4], job.pool_address.data(), 20 );
+    words[7] = job.diff;
+
+    bool changed{ false };
+    for( size_t i{ 0u }; i < JOB_WORDS; ++i )
+    {
+      changed |= m_segment->job[i].load( std::memory_order_relaxed ) != words[i];
+    }
+    if( !changed ) { return; }
+
+    // only the leader writes, so there's no other writer to keep out; a
+    // count left odd by a leader that died mid-write is simply moved on
+    uint64_t const seq{ (m_segment->job_seq.load( std::memory_order_relaxed ) + 1u) | 1u };
+    m_segment->job_seq.store( seq, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    for( size_t i{ 0u }; i < JOB_WORDS; ++i )
+    {
+      m_segment->job[i].store( words[i], std::memory_order_relaxed );
+    }
+    m_segment->job_seq.store( seq + 1u, std::memory_order_release );
+  }
+
+  auto ReadJob( pool_job_t& job ) -> bool
+  {
+    std::array<uint64_t, JOB_WORDS> words;
+
+    uint64_t const seq{ m_segment->job_seq.load( std::memory_order_acquire ) };
+    // nothing yet, nothing new, or being written - in which case the next
+    // poll will have it
+    if( seq == m_job_seen || (seq & 1u) ) { return false; }
+
+    for( size_t i{ 0u }; i < JOB_WORDS; ++i )
+    {
+      words[i] = m_segment->job[i].load( std::memory_order_relaxed );
+    }
+    std::atomic_thread_fence( std::memory_order_acquire );
+    if( m_segment->job_seq.load( std::memory_order_relaxed ) != seq ) { return false; }
+
+    m_job_seen = seq;
+    std::memcpy( job.challenge.data(), words.data(), 32 );
+    std::memcpy( job.pool_address.data(), &words[4], 20 );
+    job.diff = words[7];
+    return true;
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _SHAREDWORK_H_
+#define _SHAREDWORK_H_
+
+#include "types.h"
+
+#include <cstdint>
+#include <string>
+
+// With "shared_memory", every instance on a host joins one named segment.
+// They lease nonces from a single counter there, over a single solution
+// template, so no two ever hash the same message. Only one of them - the
+// leader - polls the pool for work; it publishes what it gets, and the
+// rest pick it up from the segment. Each instance still submits its own
+// shares.
+namespace Nabiki::SharedWork
+{
+  // the work the leader last had from the pool; `diff` is 0 when the
+  // leader sets its own
+  struct pool_job_t
+  {
+    hash_t challenge;
+    address_t pool_address;
+    uint64_t diff;
+  };
+
+  // Joins the segment `name`, creating it if this is the first instance
+  // on the host. The first instance's `solution` is handed to everyone
+  // who joins later, so the shared counter keeps them all apart.
+  auto Join( std::string const& name, hash_t& solution ) -> bool;
+  // hands over leadership at once, instead of after it times out
+  auto Leave() -> void;
+  auto IsJoined() -> bool;
+
+  // the first of `count` nonces no other instance will be given
+  auto LeaseNonces( uint64_t const& count ) -> uint64_t;
+
+  // Whether this instance should be polling the pool. Renews the lease
+  // while it is, and takes over from a leader that's left or gone quiet.
+  auto IsLeader() -> bool;
+  auto PublishJob( pool_job_t const& job ) -> void;
+  // true, with the job filled in, if the leader has published anything
+  // since the last call
+  auto ReadJob( pool_job_t& job ) -> bool;
+}
+
+#endif // !_SHAREDWORK_H_
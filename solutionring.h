@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _SOLUTIONRING_H_
+#define _SOLUTIONRING_H_
+
+#include "types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// A bounded ring of found nonces that any number of solver threads push
+// into and one thread - whoever submits them - pops from. Pushing never
+// blocks and never allocates: a full ring turns the nonce away instead,
+// and the caller counts it. Each cell carries a sequence number telling
+// producers and the consumer whose turn it is, after Vyukov's bounded
+// queue.
+template<size_t N>
+class SolutionRing
+{
+  static_assert( N > 1u && (N & (N - 1u)) == 0u, "ring size must be a power of two" );
+
+public:
+  SolutionRing() noexcept :
+    m_head( 0u ),
+    m_tail( 0u )
+  {
+    for( size_t i{ 0u }; i < N; ++i )
+    {
+      m_cells[i].seq.store( i, std::memory_order_relaxed );
+    }
+  }
+
+  auto push( found_t const& found ) noexcept -> bool
+  {
+    uint64_t pos{ m_tail.load( std::memory_order_relaxed ) };
+    for( ;; )
+    {
+      cell_t& cell{ m_cells[pos & (N - 1u)] };
+      int64_t const lag{ static_cast<int64_t>( cell.seq.load( std::memory_order_acquire ) - pos ) };
+      if( lag == 0 )
+      {
+        if( m_tail.compare_exchange_weak( pos, pos + 1u, std::memory_order_relaxed ) )
+        {
+          cell.found = found;
+          cell.seq.store( pos + 1u, std::memory_order_release );
+          return true;
+        }
+      }
+      else if( lag < 0 )
+      {
+        return false; // still holding what was pushed a lap ago
+      }
+      else
+      {
+        pos = m_tail.load( std::memory_order_relaxed );
+      }
+    }
+  }
+
+  // consumer only
+  auto pop( found_t& found ) noexcept -> bool
+  {
+    cell_t& cell{ m_cells[m_head & (N - 1u)] };
+    if( cell.seq.load( std::memory_order_acquire ) != m_head + 1u ) { return false; }
+
+    found = cell.found;
+    cell.seq.store( m_head + N, std::memory_order_release );
+    ++m_head;
+    return true;
+  }
+
+private:
+  struct cell_t
+  {
+    std::atomic<uint64_t> seq;
+    found_t found;
+  };
+
+  // the consumer's end and the producers' end each get a line of their own
+  alignas(CACHE_LINE_SIZE) uint64_t m_head;
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_tail;
+  alignas(CACHE_LINE_SIZE) std::array<cell_t, N> m_cells;
+};
+
+#endif // !_SOLUTIONRING_H_
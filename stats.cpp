@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "stats.h"
+#include "minercore.h"
+#include "isolver.h"
+#include "types.h"
+#include "ui.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+  static auto constexpr SAMPLE_INTERVAL{ 100ms };
+
+  static std::atomic<double> m_hashrate{ 0. };
+  static std::atomic<uint64_t> m_hash_count{ 0ull };
+  static std::atomic<uint64_t> m_round_start_count{ 0ull };
+
+  static std::thread m_thread;
+  static std::mutex m_stop_mutex;
+  static std::condition_variable m_stop_cv;
+  static bool m_stop{ false };
+  static bool m_started{ false };
+
+  static auto sampler() -> void
+  {
+    // each device's count as of the last sample; a device that's been
+    // restarted counts up from 0 again, and only the new part is added
+    std::vector<std::pair<ISolver const*, uint64_t>> last;
+
+    cond_lock lock{ m_stop_mutex };
+    while( !m_stop_cv.wait_for( lock, SAMPLE_INTERVAL, []{ return m_stop; } ) )
+    {
+      double hashrate{ 0. };
+      uint64_t added{ 0u };
+      std::vector<std::pair<ISolver const*, uint64_t>> current;
+
+      for( auto const& device : MinerCore::getDeviceReferences() )
+      {
+        uint64_t const count{ device->getHashCount() };
+        uint64_t before{ 0u };
+        for( auto const& [seen, seen_count] : last )
+        {
+          if( seen == device.get() ) { before = seen_count; }
+        }
+
+        added += count >= before ? count - before : count;
+        hashrate += device->getHashrate();
+        current.emplace_back( device.get(), count );
+      }
+      last.swap( current );
+
+      m_hashrate.store( hashrate, std::memory_order_release );
+      uint64_t const total{ m_hash_count.fetch_add( added, std::memory_order_acq_rel ) + added };
+
+      UI::UpdateHashrate( hashrate, total - m_round_start_count.load( std::memory_order_acquire ) );
+    }
+  }
+}
+
+namespace Stats
+{
+  auto Init() -> void
+  {
+    if( m_started ) return;
+
+    m_thread = std::thread( &sampler );
+
+    m_started = true;
+  }
+
+  auto Cleanup() -> void
+  {
+    if( !m_started ) return;
+
+    {
+      guard lock{ m_stop_mutex };
+      m_stop = true;
+    }
+    m_stop_cv.notify_all();
+    if( m_thread.joinable() )
+      m_thread.join();
+  }
+
+  auto GetHashrate() -> double
+  {
+    return m_hashrate.load( std::memory_order_acquire );
+  }
+
+  auto GetHashCount() -> uint64_t
+  {
+    return m_hash_count.load( std::memory_order_acquire );
+  }
+
+  auto GetRoundHashCount() -> uint64_t
+  {
+    // the start first: it only ever moves up to a count already reached
+    uint64_t const start{ m_round_start_count.load( std::memory_order_acquire ) };
+    return m_hash_count.load( std::memory_order_acquire ) - start;
+  }
+
+  auto NewRound() -> void
+  {
+    m_round_start_count.store( m_hash_count.load( std::memory_order_acquire ), std::memory_order_release );
+  }
+}
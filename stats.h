@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018 Azlehria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined _STATS_H_
+#define _STATS_H_
+
+#include <cstdint>
+
+// Every 100 ms a thread of its own totals what the devices have hashed
+// and how fast, and hands that to the UI; telemetry and anyone else read
+// the latest totals. The mining threads never wait on any of it.
+namespace Stats
+{
+  auto Init() -> void;
+  auto Cleanup() -> void;
+
+  // MH/s across every device
+  auto GetHashrate() -> double;
+  // hashed since startup
+  auto GetHashCount() -> uint64_t;
+  // hashed since the last NewRound()
+  auto GetRoundHashCount() -> uint64_t;
+  auto NewRound() -> void;
+}
+
+#endif // !_STATS_H_
@@ -26,6 +26,7 @@
 #include "miner_state.h"
 #include "minercore.h"
 #include "commo.h"
+#include "stats.h"
 
 #include <cstdint>
 #include <cstring>
@@ -56,7 +57,8 @@ namespace
                                          { "mem_clock"s, device->getClockMem() },
                                          { "power"s, device->getPowerWatts() },
                                          { "temp"s, device->getTemperature() },
-                                         { "fan"s, device->getFanSpeed() } } );
+                                         { "fan"s, device->getFanSpeed() },
+                                         { "switch_ms"s, device->getSwitchTime() } } );
 
       body["hashrate"]["threads"][device_id].emplace_back( uint64_t( device->getHashrate() ) );
 
@@ -80,7 +82,10 @@ namespace
     body["results"]["shares_good"] = MinerState::getSolCount();
     body["results"]["shares_total"] = Commo::GetTotalShares();
     //body["results"]["avg_time"] = 0;
-    body["results"]["hashes_total"] = MinerState::getIncSearchSpace( 0u );
+    body["results"]["hashes_total"] = Stats::GetHashCount();
+    // not part of the XMRig API: from the last new challenge until every
+    // device was hashing it
+    body["results"]["switch_latency_ms"] = MinerCore::getSwitchLatency();
 
     std::stringstream ss_out;
 
@@ -46,7 +46,6 @@ using namespace Nabiki::Events;
 
 namespace
 {
-  static double hashrate{ 0 };
   static seconds timer{};
   static time_point<steady_clock> timerNext{};
   static std::locale systemLocale( "" );
@@ -263,19 +262,8 @@ namespace UI
     SendEvent( UI_UPDATE_ADDRESS, qEvents );
   }
 
-  auto UpdateHashrate( uint64_t const& count ) -> void
+  auto UpdateHashrate( double const& hashrate, uint64_t const& count ) -> void
   {
-    // print every every 100 milliseconds . . . more or less
-    static auto time_counter{ steady_clock::now() + 100ms };
-    if( time_counter > steady_clock::now() ) return;
-    time_counter = steady_clock::now() + 100ms;
-
-    hashrate = 0;
-    for( auto const& temp : MinerCore::getHashrates() )
-    {
-      hashrate += temp;
-    }
-
     dHashrate = hashrate;
     lHashCount = count;
     SendEvent( UI_UPDATE_HASHRATE, qEvents );
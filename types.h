@@ -39,10 +39,15 @@ using message_t  = std::array<uint8_t,  84u>;
 using state_t    = std::array<uint8_t, 200u>;
 using address_t  = std::array<uint8_t,  20u>;
 using solution_t = std::array<uint8_t,   8u>;
+using midstate_t = std::array<uint64_t, 30u>; // see midstate.h
 
 using device_list_t = std::vector<std::pair<int32_t, double>>;
 using device_map_t  = std::vector<std::pair<std::string, device_list_t>>;
 
+// anything written by one thread while others touch its neighbours gets
+// a line of its own; 64 bytes covers every x86 part we care about
+inline size_t constexpr CACHE_LINE_SIZE{ 64u };
+
 using guard     = std::lock_guard<std::mutex>;
 using cond_lock = std::unique_lock<std::mutex>;
 
@@ -57,6 +62,23 @@ struct device_info_t
   uint32_t fan;
 };
 
+// a nonce some device found, and the epoch of the job it was found for
+// (see job_t in miner_state.h)
+struct found_t
+{
+  uint64_t nonce;
+  uint64_t job;
+};
+
+// what --autotune settled on for one device, with zeroes for anything
+// it didn't look at; see "autotune" in nabiki.json
+struct tuning_t
+{
+  double intensity;
+  uint32_t work_size;
+  uint32_t threads;
+};
+
 enum device_type_t
 {
   DEVICE_CUDA,
@@ -37,7 +37,8 @@ namespace UI
   auto UpdateDifficulty( uint64_t const& diff ) -> void;
   auto UpdateUrl( std::string_view const& url ) -> void;
   auto UpdateAddress( std::string_view const address ) -> void;
-  auto UpdateHashrate( uint64_t const& count ) -> void;
+  // total MH/s, and the hashes done this round; called by Stats
+  auto UpdateHashrate( double const& hashrate, uint64_t const& count ) -> void;
   auto UpdateSolutions( uint64_t const& count ) -> void;
   auto UpdateDevSolutions( uint64_t const& count ) -> void;
 }
@@ -47,7 +47,10 @@
 #include <Windows.h>
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 long NTAPI NtQueryTimerResolution( uint32_t* MinimumResolution, uint32_t* MaximumResolution, uint32_t* CurrentResolution );
 long NTAPI NtSetTimerResolution( uint32_t DesiredResolution, BOOLEAN SetResolution, uint32_t CurrentResolution );
@@ -196,4 +199,200 @@ auto GetRawCpuName() -> std::string
   return out;
 }
 
+auto GetCpuFeatures() -> uint32_t
+{
+  std::array<int32_t, 4> registers;
+  uint32_t features{ 0u };
+
+  __cpuidex( registers.data(), 0, 0 );
+  int32_t const max_leaf{ registers[0] };
+  if( max_leaf < 1 ) { return features; }
+
+  __cpuidex( registers.data(), 1, 0 );
+  if( registers[3] & (1 << 26) ) { features |= CPU_SSE2; }
+
+  // the YMM/ZMM state has to be enabled by the OS, not just present
+  uint64_t const xcr0{ (registers[2] & (1 << 27)) ? _xgetbv( 0 ) : 0u };
+  bool const os_avx{ (xcr0 & 0x06u) == 0x06u };
+  bool const os_avx512{ (xcr0 & 0xe6u) == 0xe6u };
+
+  if( max_leaf < 7 ) { return features; }
+
+  __cpuidex( registers.data(), 7, 0 );
+  if( (registers[1] & (1 << 3)) && (registers[1] & (1 << 8)) ) { features |= CPU_BMI2; }
+  if( (registers[1] & (1 << 5)) && os_avx ) { features |= CPU_AVX2; }
+  if( (registers[1] & (1 << 16)) && os_avx512 ) { features |= CPU_AVX512F; }
+
+  return features;
+}
+
+auto GetCpuTopology() -> std::vector<cpu_info_t>
+{
+  std::vector<cpu_info_t> cpus;
+
+  // affinity masks are per processor group; like the rest of the miner,
+  // only the first group (up to 64 logical processors) is used
+  DWORD_PTR process_mask, system_mask;
+  if( !GetProcessAffinityMask( GetCurrentProcess(), &process_mask, &system_mask ) ) { return cpus; }
+
+  DWORD length{ 0u };
+  GetLogicalProcessorInformationEx( RelationAll, nullptr, &length );
+  auto buffer{ std::make_unique<uint8_t[]>( length ) };
+  if( !GetLogicalProcessorInformationEx( RelationAll,
+                                         reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.get()),
+                                         &length ) ) { return cpus; }
+
+  std::array<cpu_info_t, 64> info{};
+  uint32_t core{ 0u }, package{ 0u };
+  for( DWORD offset{ 0u }; offset < length; )
+  {
+    auto const& entry{ *reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.get() + offset) };
+    offset += entry.Size;
+
+    for( uint32_t cpu{ 0u }; cpu < 64u; ++cpu )
+    {
+      KAFFINITY const bit{ KAFFINITY( 1u ) << cpu };
+      switch( entry.Relationship )
+      {
+        case RelationProcessorCore:
+          if( entry.Processor.GroupMask[0].Group == 0 && (entry.Processor.GroupMask[0].Mask & bit) ) { info[cpu].core = core; }
+          break;
+        case RelationProcessorPackage:
+          if( entry.Processor.GroupMask[0].Group == 0 && (entry.Processor.GroupMask[0].Mask & bit) ) { info[cpu].package = package; }
+          break;
+        case RelationNumaNode:
+          if( entry.NumaNode.GroupMask.Group == 0 && (entry.NumaNode.GroupMask.Mask & bit) ) { info[cpu].node = entry.NumaNode.NodeNumber; }
+          break;
+        default:
+          break;
+      }
+    }
+
+    if( entry.Relationship == RelationProcessorCore ) { ++core; }
+    if( entry.Relationship == RelationProcessorPackage ) { ++package; }
+  }
+
+  for( uint32_t cpu{ 0u }; cpu < 64u; ++cpu )
+  {
+    if( !(process_mask & (DWORD_PTR( 1u ) << cpu)) ) { continue; }
+
+    info[cpu].id = cpu;
+    cpus.emplace_back( info[cpu] );
+  }
+
+  return cpus;
+}
+
+auto GetPciNode( std::string const& ) -> int32_t
+{
+  // no cheap way to map PCI devices to NUMA nodes here; callers treat
+  // this as "unknown"
+  return -1;
+}
+
+auto SetThreadAffinity( uint32_t const& cpu ) -> bool
+{
+  if( cpu >= 64u ) { return false; }
+
+  return SetThreadAffinityMask( GetCurrentThread(), DWORD_PTR( 1u ) << cpu ) != 0;
+}
+
+auto SetThreadIdlePriority() -> bool
+{
+  return SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_IDLE ) != 0;
+}
+
+auto GetSystemLoad() -> double
+{
+  // there's no load average here, so measure busy time between calls
+  static uint64_t last_idle{ 0u }, last_total{ 0u };
+
+  FILETIME idle, kernel, user;
+  if( !GetSystemTimes( &idle, &kernel, &user ) ) { return -1; }
+
+  auto const to_u64 = []( FILETIME const& ft ) { return uint64_t( ft.dwHighDateTime ) << 32 | ft.dwLowDateTime; };
+  // kernel time includes idle time
+  uint64_t const t_idle{ to_u64( idle ) }, t_total{ to_u64( kernel ) + to_u64( user ) };
+  if( last_total == 0u || t_total == last_total )
+  {
+    last_idle = t_idle;
+    last_total = t_total;
+    return -1;
+  }
+
+  double const busy{ 1.0 - double( t_idle - last_idle ) / double( t_total - last_total ) };
+  last_idle = t_idle;
+  last_total = t_total;
+
+  SYSTEM_INFO info;
+  GetSystemInfo( &info );
+  return busy * info.dwNumberOfProcessors;
+}
+
+auto GetCpuPressure() -> double
+{
+  return -1;
+}
+
+auto AllocExecutable( size_t const& size ) -> void*
+{
+  return VirtualAlloc( nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+}
+
+auto ProtectExecutable( void* code, size_t const& size ) -> bool
+{
+  DWORD old_protect;
+  if( !VirtualProtect( code, size, PAGE_EXECUTE_READ, &old_protect ) ) { return false; }
+
+  return FlushInstructionCache( GetCurrentProcess(), code, size ) != 0;
+}
+
+auto FreeExecutable( void* code, [[maybe_unused]] size_t const& size ) -> void
+{
+  VirtualFree( code, 0u, MEM_RELEASE );
+}
+
+// the mapping handle has to outlive the view; only ever touched from the
+// main thread, at startup and shutdown
+static std::vector<std::pair<void*, HANDLE>> shared_mappings;
+
+auto MapSharedMemory( std::string const& name, size_t const& size, bool& created ) -> void*
+{
+  std::string const path{ "Local\\"s + name };
+  HANDLE const mapping{ CreateFileMappingA( INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                            static_cast<DWORD>( uint64_t( size ) >> 32 ),
+                                            static_cast<DWORD>( size ), path.c_str() ) };
+  if( !mapping ) { return nullptr; }
+  created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+  void* const memory{ MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0u, 0u, size ) };
+  if( !memory )
+  {
+    CloseHandle( mapping );
+    return nullptr;
+  }
+
+  shared_mappings.emplace_back( memory, mapping );
+  return memory;
+}
+
+auto UnmapSharedMemory( void* memory, [[maybe_unused]] size_t const& size ) -> void
+{
+  UnmapViewOfFile( memory );
+  for( auto it{ shared_mappings.begin() }; it != shared_mappings.end(); ++it )
+  {
+    if( it->first == memory )
+    {
+      CloseHandle( it->second );
+      shared_mappings.erase( it );
+      break;
+    }
+  }
+}
+
+// named mappings go away with their last handle
+auto RemoveSharedMemory( [[maybe_unused]] std::string const& name ) -> void
+{
+}
+
 #endif // _MSC_VER